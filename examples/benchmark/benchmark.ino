@@ -0,0 +1,170 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Benchmark example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Measure how long library calls take
+ *
+ * Results are printed as CSV:
+ * Payload sizes: payload size, write() time (us), read() time (us), write() bytes/us, read() bytes/us
+ * Operations: operation, time per call (us)
+ *
+ * The operation names are the same as the ones printed by extras/host/benchmark.cpp so results can be compared.
+ *
+ * Try changing NRF905_SPI_BLOCK_TRANSFER in nRF905_config.h to compare block transfers against byte-at-a-time transfers.
+ * Try setting NRF905_FAST_GPIO to 1 (AVR only) to compare direct port access against digitalWrite()/digitalRead(), RX_standby, airwayBusy and mode only use
+ * the pins so they show the difference the most, chip select is also used by every SPI operation.
+ */
+
+#include <nRF905.h>
+#include <nRF905_hop.h>
+#include <SPI.h>
+
+#define ADDR		0xB54CAB34
+#define ITERATIONS	100
+
+nRF905 transceiver = nRF905();
+nRF905Hop hop = nRF905Hop();
+
+static uint8_t buffer[NRF905_MAX_PAYLOAD];
+
+// Time ITERATIONS calls of fn, setup is run before each call but isn't timed
+static void bench(const __FlashStringHelper* op, void (*setup)(), void (*fn)())
+{
+	unsigned long total = 0;
+	for(uint8_t i=0;i<ITERATIONS;i++)
+	{
+		if(setup != NULL)
+			setup();
+		unsigned long start = micros();
+		fn();
+		total += micros() - start;
+	}
+
+	Serial.print(op);
+	Serial.print(F(","));
+	Serial.println(total / (float)ITERATIONS, 3);
+}
+
+static void standby()
+{
+	transceiver.standby();
+	delay(10); // Let any transmissions finish
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	// This must be called first
+	SPI.begin();
+
+	// Polled mode so .poll() can be measured
+	transceiver.begin(
+		SPI, // SPI bus to use (SPI, SPI1, SPI2 etc)
+		10000000, // SPI Clock speed (10MHz)
+		6, // SPI SS
+		7, // CE (standby)
+		9, // TRX (RX/TX mode)
+		8, // PWR (power down)
+		4, // CD
+		NRF905_PIN_UNUSED, // DR
+		NRF905_PIN_UNUSED, // AM
+		NULL, // No interrupt function
+		NULL // No interrupt function
+	);
+
+	transceiver.standby();
+
+	// Hop table for measuring retunes, only hops when .next() is called
+	hop.begin(transceiver, NRF905_BAND_433, 433100000, 434700000, 1, 0);
+
+	memset(buffer, 0xA5, sizeof(buffer));
+}
+
+void loop()
+{
+	Serial.println(F("size,write_us,read_us,write_bytes_per_us,read_bytes_per_us"));
+
+	for(uint8_t size=1;size<=NRF905_MAX_PAYLOAD;size++)
+	{
+		unsigned long start = micros();
+		for(uint8_t i=0;i<ITERATIONS;i++)
+			transceiver.write(ADDR, buffer, size);
+		float writeTime = (micros() - start) / (float)ITERATIONS;
+
+		start = micros();
+		for(uint8_t i=0;i<ITERATIONS;i++)
+			transceiver.read(buffer, size);
+		float readTime = (micros() - start) / (float)ITERATIONS;
+
+		Serial.print(size);
+		Serial.print(F(","));
+		Serial.print(writeTime);
+		Serial.print(F(","));
+		Serial.print(readTime);
+		Serial.print(F(","));
+		Serial.print(size / writeTime, 3);
+		Serial.print(F(","));
+		Serial.println(size / readTime, 3);
+	}
+
+	Serial.println();
+	Serial.print(F("NRF905_FAST_GPIO,"));
+	Serial.println(NRF905_FAST_GPIO);
+	Serial.println(F("op,time_us"));
+
+	bench(F("write_1"), NULL, []{ transceiver.write(ADDR, buffer, 1); });
+	bench(F("write_8"), NULL, []{ transceiver.write(ADDR, buffer, 8); });
+	bench(F("write_32"), NULL, []{ transceiver.write(ADDR, buffer, 32); });
+	bench(F("write_newaddr_32"), NULL, []{ static uint32_t addr; transceiver.write(addr++, buffer, 32); });
+	bench(F("writePayload_32"), NULL, []{ transceiver.writePayload(buffer, 32); });
+	bench(F("patchPayload_2"), NULL, []{ transceiver.patchPayload(buffer, 2); });
+	bench(F("read_1"), NULL, []{ transceiver.read(buffer, 1); });
+	bench(F("read_32"), NULL, []{ transceiver.read(buffer, 32); });
+	bench(F("setChannel"), NULL, []{ static uint16_t ch; transceiver.setChannel(ch++ & 511); });
+	bench(F("setChannel_batched"), NULL, []{ static uint16_t ch; transceiver.beginConfig(); transceiver.setChannel(ch++ & 511); transceiver.commitConfig(); });
+	bench(F("hop_next"), NULL, []{ hop.next(); });
+	bench(F("scanChannels_16"), NULL, []{ uint8_t occupancy[16]; transceiver.scanChannels(0, 15, 250, occupancy); });
+	bench(F("setTransmitPower"), NULL, []{ transceiver.setTransmitPower(NRF905_PWR_10); });
+	bench(F("setPayloadSize"), NULL, []{ transceiver.setPayloadSize(32, 32); });
+	bench(F("setListenAddress"), NULL, []{ transceiver.setListenAddress(ADDR); });
+	bench(F("profile_separate"), NULL, []{
+		transceiver.setChannel(100);
+		transceiver.setBand(NRF905_BAND_433);
+		transceiver.setTransmitPower(NRF905_PWR_6);
+		transceiver.setCRC(NRF905_CRC_16);
+		transceiver.setPayloadSize(16, 16);
+	});
+	bench(F("profile_batched"), NULL, []{
+		transceiver.beginConfig();
+		transceiver.setChannel(100);
+		transceiver.setBand(NRF905_BAND_433);
+		transceiver.setTransmitPower(NRF905_PWR_6);
+		transceiver.setCRC(NRF905_CRC_16);
+		transceiver.setPayloadSize(16, 16);
+		transceiver.commitConfig();
+	});
+	bench(F("getConfigRegisters"), NULL, []{ uint8_t regs[NRF905_REGISTER_COUNT]; transceiver.getConfigRegisters(regs); });
+	bench(F("TX_standby"), standby, []{ transceiver.TX(NRF905_NEXTMODE_STANDBY, false); });
+	bench(F("TX_rx"), standby, []{ transceiver.TX(NRF905_NEXTMODE_RX, false); });
+	bench(F("startTX_rx"), standby, []{ transceiver.startTX(NRF905_NEXTMODE_RX, false); });
+	bench(F("poll"), NULL, []{ transceiver.poll(); });
+	bench(F("mode"), NULL, []{ transceiver.mode(); });
+	bench(F("RX_standby"), NULL, []{ transceiver.RX(); transceiver.standby(); });
+	bench(F("airwayBusy"), NULL, []{ transceiver.airwayBusy(); });
+
+	// Put the settings back to normal
+	transceiver.setBand(NRF905_BAND);
+	transceiver.setChannel(NRF905_CHANNEL);
+	transceiver.setTransmitPower(NRF905_PWR);
+	transceiver.setPayloadSize(NRF905_PAYLOAD_SIZE_TX, NRF905_PAYLOAD_SIZE_RX);
+	transceiver.standby();
+
+	Serial.println();
+	delay(5000);
+}
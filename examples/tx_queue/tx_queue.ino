@@ -0,0 +1,139 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Transmit queue example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Queue up a few payloads at once and let the library send them back-to-back.
+ * NRF905_TX_QUEUE_SLOTS in nRF905_config.h must be set to a power of 2, for example 4.
+ * The ping_server example (or anything listening on TXADDR) can be used as the receiver.
+ */
+
+#include <nRF905.h>
+#include <SPI.h>
+
+#if !NRF905_TX_QUEUE_SLOTS
+	#error "Set NRF905_TX_QUEUE_SLOTS in nRF905_config.h for this example"
+#endif
+
+#define TXADDR 0xE7E7E7E7 // Address of device to send to
+
+#define PAYLOAD_SIZE	NRF905_MAX_PAYLOAD // 32
+
+nRF905 transceiver = nRF905();
+
+static volatile uint32_t completed;
+
+// Don't modify these 2 functions. They just pass the DR/AM interrupt to the correct nRF905 instance.
+void nRF905_int_dr(){transceiver.interrupt_dr();}
+void nRF905_int_am(){transceiver.interrupt_am();}
+
+// Event function for TX complete, runs after each queued payload has been sent
+void nRF905_onTxComplete(nRF905* device)
+{
+	completed++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	Serial.println(F("Transmit queue starting..."));
+
+	// This must be called first
+	SPI.begin();
+
+	transceiver.begin(
+		SPI, // SPI bus to use (SPI, SPI1, SPI2 etc)
+		10000000, // SPI Clock speed (10MHz)
+		6, // SPI SS
+		7, // CE (standby)
+		9, // TRX (RX/TX mode)
+		8, // PWR (power down)
+		4, // CD (collision avoid)
+		3, // DR (data ready)
+		2, // AM (address match)
+		nRF905_int_dr, // Interrupt function for DR
+		nRF905_int_am // Interrupt function for AM
+	);
+
+	// Register event functions
+	transceiver.events(
+		NULL,
+		NULL,
+		nRF905_onTxComplete,
+		NULL
+	);
+
+	transceiver.setPayloadSize(PAYLOAD_SIZE, PAYLOAD_SIZE);
+
+	// Go to standby mode once the queue is empty (this is the default)
+	transceiver.setTxQueueNextMode(NRF905_NEXTMODE_STANDBY);
+
+	Serial.println(F("Transmit queue started"));
+}
+
+void loop()
+{
+	static uint8_t counter;
+
+	// Fill the queue, the first payload starts sending straight away
+	uint8_t buffer[PAYLOAD_SIZE];
+	int16_t firstId = -1;
+	int16_t lastId = -1;
+	uint8_t queued = 0;
+	while(1)
+	{
+		memset(buffer, counter, PAYLOAD_SIZE);
+
+		int16_t id = transceiver.enqueue(TXADDR, buffer, sizeof(buffer));
+		if(id < 0)
+			break; // Queue is full
+
+		if(firstId < 0)
+			firstId = id;
+		lastId = id;
+		queued++;
+		counter++;
+	}
+
+	uint32_t startTime = millis();
+	bool firstSent = false;
+
+	// .service() sends the rest of the queue, it must be called often until the queue is empty
+	// Uncomment the .poll() line if the library is running in polling mode
+	while(transceiver.txQueueLength())
+	{
+//		transceiver.poll();
+		transceiver.service();
+
+		if(!firstSent && transceiver.txQueueSent(firstId))
+		{
+			firstSent = true;
+			Serial.print(F("First payload sent after "));
+			Serial.print(millis() - startTime);
+			Serial.println(F("ms"));
+		}
+	}
+
+	uint16_t totalTime = millis() - startTime;
+
+	Serial.print(F("Sent "));
+	Serial.print(queued);
+	Serial.print(F(" payloads (IDs "));
+	Serial.print(firstId);
+	Serial.print(F(" to "));
+	Serial.print(lastId);
+	Serial.print(F(") in "));
+	Serial.print(totalTime);
+	Serial.println(F("ms"));
+
+	Serial.print(F("Total sent: "));
+	Serial.println(completed);
+	Serial.println(F("------"));
+
+	delay(1000);
+}
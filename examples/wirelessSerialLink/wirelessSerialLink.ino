@@ -1,22 +1,18 @@
 /*
- * Project: nRF905 AVR/Arduino Library/Driver (Wireless serial link example)
- * Author: Zak Kemble, contact@zakkemble.co.uk
- * Copyright: (C) 2017 by Zak Kemble
+ * Project: nRF905 Radio Library for Arduino (Wireless serial link example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
  * License: GNU GPL v3 (see License.txt)
- * Web: http://blog.zakkemble.co.uk/nrf905-avrarduino-librarydriver/
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
  */
 
-//
-// DONT USE THIS EXAMPLE, IT STILL NEEDS TO BE UPDATED FOR THE NEW VERSION OF THE NRF905 LIBRARY (v4)
-//
-
 /*
  * Wireless serial link
  *
- * TODO
- * Don't drop DATA/ACK packets
- * Buffer up incoming packets
- * Buffer up incoming UART data with a small timeout (~5ms?) before sending
+ * Anything received on the UART is sent to the other device and anything received from the other device is sent out of the UART.
+ * nRF905Link takes care of resending lost packets and keeping everything in order.
+ *
+ * Upload to 2 devices, swap RXADDR and TXADDR around for the second device.
  *
  * 7 -> CE
  * 8 -> PWR
@@ -31,162 +27,87 @@
  */
 
 #include <nRF905.h>
+#include <nRF905_link.h>
+#include <SPI.h>
 
-#define PACKET_TYPE_DATA	0
-#define PACKET_TYPE_ACK		1
+#define RXADDR 0xE7E7E7E7 // Address of this device
+#define TXADDR 0xE7E7E7E7 // Address of device to send to
 
-#define MAX_PACKET_SIZE (NRF905_MAX_PAYLOAD - 2)
-typedef struct {
-	byte dstAddress[NRF905_ADDR_SIZE];
-	byte type;
-	byte len;
-	byte data[MAX_PACKET_SIZE];
-} packet_t;
+#define UART_TIMEOUT	5 // Wait this many ms for more UART data before sending a part filled packet
 
-static volatile byte newData[NRF905_MAX_PAYLOAD];
-static volatile bool gotNewData;
+nRF905 transceiver = nRF905();
+nRF905Link link = nRF905Link();
 
-void NRF905_CB_RXCOMPLETE(void)
-{
-	gotNewData = true;
-	nRF905_read((byte*)newData, sizeof(newData));
-	
-	// Still in RX mode
-}
+// Don't modify these 2 functions. They just pass the DR/AM interrupt to the correct nRF905 instance.
+void nRF905_int_dr(){transceiver.interrupt_dr();}
+void nRF905_int_am(){transceiver.interrupt_am();}
 
-void NRF905_CB_TXCOMPLETE(void)
+// Event function for RX complete
+void nRF905_onRxComplete(nRF905* device)
 {
-	nRF905_RX();
+	link.receive();
 }
 
 void setup()
 {
-	// Start up
-	nRF905_init();
+	Serial.begin(115200);
+
+	// This must be called first
+	SPI.begin();
+
+	transceiver.begin(
+		SPI,
+		10000000,
+		10, // SPI SS
+		7, // CE (standby)
+		9, // TRX (RX/TX mode)
+		8, // PWR (power down)
+		4, // CD (collision avoid)
+		3, // DR (data ready)
+		2, // AM (address match)
+		nRF905_int_dr,
+		nRF905_int_am
+	);
+
+	transceiver.events(
+		nRF905_onRxComplete,
+		NULL,
+		NULL,
+		NULL
+	);
+
+	transceiver.setListenAddress(RXADDR);
+
+	link.begin(transceiver, TXADDR);
 
-	// Put into receive mode
-	nRF905_RX();
-
-	Serial.begin(19200);
 	Serial.println(F("Ready"));
 }
 
 void loop()
 {
-	packet_t packet;
+	static uint8_t buffer[NRF905_LINK_MAX_DATA];
+	static uint8_t len;
+	static uint32_t lastByte;
 
-	// Send serial data
-	byte dataSize;
-	while((dataSize = Serial.available()))
+	// Collect UART data
+	while(Serial.available() && len < sizeof(buffer))
 	{
-		// Make sure we don't try to send more than max packet size
-		if(dataSize > MAX_PACKET_SIZE)
-			dataSize = MAX_PACKET_SIZE;
-
-		packet.type = PACKET_TYPE_DATA;
-		packet.len = dataSize;
-
-		// Copy data from serial to packet buffer
-		for(byte i=0;i<dataSize;i++)
-			packet.data[i] = Serial.read();
-
-		// Send packet
-		sendPacket(&packet);
-
-		// Wait for ACK packet
-		byte startTime = millis();
-		while(1)
-		{
-			bool timeout = false;
-			while(1)
-			{
-				if(getPacket(&packet)) // Get new packet
-					break;
-				else if((byte)(millis() - startTime) > 50) // 50ms timeout
-				{
-					timeout = true;
-					break;
-				}
-			}
-
-			if(timeout) // Timed out
-			{
-				Serial.println(F("TO"));
-				break;
-			}
-			else if(packet.type == PACKET_TYPE_ACK) // Is packet type ACK?
-				break;
-			
-			// drop DATA type packets
-		}
+		buffer[len++] = Serial.read();
+		lastByte = millis();
 	}
 
-	// Wait for data
-	while(1)
+	// Send once the buffer is full or no more UART data has arrived for a while
+	if(len == sizeof(buffer) || (len && (uint32_t)(millis() - lastByte) >= UART_TIMEOUT))
 	{
-		if(getPacket(&packet) && packet.type == PACKET_TYPE_DATA) // Got a packet and is it a data packet?
-		{
-			// Print data
-			Serial.write(packet.data, packet.len);
-
-			// Reply with ACK
-			packet.type = PACKET_TYPE_ACK;
-			packet.len = 0;
-			sendPacket(&packet);
-		}
-		else if(Serial.available()) // We've got some serial data, need to send it
-			break;
-		
-		// drop ACK type packets
+		if(link.send(buffer, len))
+			len = 0;
 	}
-}
 
-// Send a packet
-static void sendPacket(void* _packet)
-{
-	// Void pointer to packet_t pointer hack
-	// Arduino puts all the function defs at the top of the file before packet_t being declared :/
-	packet_t* packet = (packet_t*)_packet;
-
-	// Convert packet data to plain byte array
-	byte totalLength = packet->len + 2;
-	byte tmpBuff[totalLength];
-	tmpBuff[0] = packet->type;
-	tmpBuff[1] = packet->len;
-	memcpy(&tmpBuff[2], packet->data, packet->len);
-
-	// Set address of device to send to
-	//nRF905_setTXAddress(packet->dstAddress);
-
-	// Send payload (send fails if other transmissions are going on, keep trying until success)
-	while(!nRF905_TX(NRF905_DEFAULT_TXADDR, tmpBuff, totalLength, NRF905_NEXTMODE_STANDBY));
-}
+	link.service();
 
-// Get a packet
-static bool getPacket(void* _packet)
-{
-	// Void pointer to packet_t pointer hack
-	// Arduino puts all the function defs at the top of the file before packet_t being declared :/
-	packet_t* packet = (packet_t*)_packet;
-
-	// See if any data available
-	if(!gotNewData)
-		return false;
-	
-	NRF905_NO_INTERRUPT()
-	{
-		gotNewData = false;
-
-		// Convert byte array to packet
-		packet->type = newData[0];
-		packet->len = newData[1];
-
-		// Sanity check
-		if(packet->len > MAX_PACKET_SIZE)
-			packet->len = MAX_PACKET_SIZE;
-
-		memcpy(packet->data, (byte*)&newData[2], packet->len);
-	}
-	
-	return true;
-}
\ No newline at end of file
+	// Output received data
+	uint8_t data[NRF905_LINK_MAX_DATA];
+	uint8_t dataLen;
+	while((dataLen = link.read(data, sizeof(data))))
+		Serial.write(data, dataLen);
+}
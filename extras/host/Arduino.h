@@ -0,0 +1,87 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+// Just enough of the Arduino API for the nRF905 library, see nRF905_sim.h
+
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HIGH	1
+#define LOW		0
+
+#define INPUT	0
+#define OUTPUT	1
+
+#define CHANGE	1
+#define FALLING	2
+#define RISING	3
+
+#define MSBFIRST	1
+#define LSBFIRST	0
+
+#define PROGMEM
+#define pgm_read_byte(addr)	(*(const uint8_t*)(addr))
+#define F(str)	(str)
+
+#define digitalPinToInterrupt(pin)	(pin)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void attachInterrupt(uint8_t interruptNum, void (*fn)(), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts();
+void interrupts();
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t data) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size)
+	{
+		size_t n = 0;
+		while(size--)
+			n += write(*buffer++);
+		return n;
+	}
+	size_t write(const char* str)
+	{
+		return write((const uint8_t*)str, strlen(str));
+	}
+	virtual int availableForWrite() { return 0; }
+	virtual void flush() {}
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+#endif /* ARDUINO_H_ */
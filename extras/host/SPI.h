@@ -0,0 +1,45 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+// SPI bus routed to the simulated radios of the current MCU, see nRF905_sim.h
+
+#ifndef SPI_H_
+#define SPI_H_
+
+#include <Arduino.h>
+
+#define SPI_MODE0	0x00
+
+class SPISettings
+{
+public:
+	uint32_t clock;
+
+	SPISettings() : clock(4000000) {}
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock)
+	{
+		(void)bitOrder;
+		(void)dataMode;
+	}
+};
+
+class SPIClass
+{
+public:
+	void begin() {}
+	void end() {}
+	void beginTransaction(SPISettings settings);
+	void endTransaction();
+	void usingInterrupt(uint8_t interruptNumber) { (void)interruptNumber; }
+	uint8_t transfer(uint8_t data);
+	void transfer(void* buf, size_t count);
+};
+
+extern SPIClass SPI;
+
+#endif /* SPI_H_ */
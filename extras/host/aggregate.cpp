@@ -0,0 +1,164 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator aggregation example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Send small telemetry records one per payload and then packed together with nRF905Aggregator
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/aggregate.cpp src/nRF905*.cpp -o aggregate
+ * ./aggregate [records] [recordSize] [interval_us] [flushTime_ms]
+ *
+ * Output is CSV:
+ * mode, records received, payloads sent, airtime (ms), average latency from creating a record to reading it (us)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_aggregator.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define SENDER_ADDR		0xB54CAB34
+#define RECEIVER_ADDR	0xA94EC554
+
+static nRF905SimAir air(1);
+static nRF905SimNode senderNode(air);
+static nRF905SimNode receiverNode(air);
+static nRF905SimRadio senderRadio(senderNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio receiverRadio(receiverNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 sender;
+static nRF905 receiver;
+static nRF905Aggregator senderAgg;
+static nRF905Aggregator receiverAgg;
+
+static uint8_t recordSize;
+static volatile bool gotPayload;
+
+static void sender_int_dr(){sender.interrupt_dr();}
+static void sender_int_am(){sender.interrupt_am();}
+static void receiver_int_dr(){receiver.interrupt_dr();}
+static void receiver_int_am(){receiver.interrupt_am();}
+static void receiver_onRxComplete(nRF905* device)
+{
+	(void)device;
+#if !NRF905_RX_BUFFER_SLOTS
+	// Otherwise read() takes payloads from the radio's receive buffer itself
+	receiverAgg.receive();
+#endif
+}
+static void receiver_onRxComplete_direct(nRF905* device){(void)device; gotPayload = true;}
+
+static void run(bool aggregate, uint32_t records, uint32_t interval, uint16_t flushTime)
+{
+	senderNode.run([&]{
+		SPI.begin();
+		sender.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, sender_int_dr, sender_int_am);
+		sender.setListenAddress(SENDER_ADDR);
+		senderAgg.begin(sender, RECEIVER_ADDR, flushTime);
+	});
+
+	receiverNode.run([&]{
+		SPI.begin();
+		receiver.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, receiver_int_dr, receiver_int_am);
+		receiver.setListenAddress(RECEIVER_ADDR);
+		receiver.events(aggregate ? receiver_onRxComplete : receiver_onRxComplete_direct, NULL, NULL, NULL);
+		receiverAgg.begin(receiver, SENDER_ADDR, flushTime);
+	});
+
+	air.advance(10000000);
+	senderRadio.resetCounters();
+
+	uint32_t created = 0;
+	uint32_t received = 0;
+	uint64_t totalLatency = 0;
+	uint64_t start = air.time();
+	uint64_t nextRecord = start;
+
+	while(received < records && air.time() - start < 60000000000ULL)
+	{
+		if(created < records && air.time() >= nextRecord)
+		{
+			// Record contains the time it was created
+			uint8_t record[NRF905_AGGREGATOR_MAX_RECORD];
+			memset(record, 0, sizeof(record));
+			uint64_t now = air.time();
+			memcpy(record, &now, sizeof(now) < recordSize ? sizeof(now) : recordSize);
+
+			senderNode.run([&]{
+				if(aggregate)
+					senderAgg.add(record, recordSize);
+				else
+				{
+					sender.write(RECEIVER_ADDR, record, recordSize);
+					while(!sender.TX(NRF905_NEXTMODE_RX, true));
+				}
+			});
+
+			created++;
+			nextRecord += interval * 1000ULL;
+		}
+
+		senderNode.run([&]{
+			if(aggregate)
+				senderAgg.service();
+		});
+
+		receiverNode.run([&]{
+			uint8_t record[NRF905_MAX_PAYLOAD];
+			uint64_t createdAt = 0;
+			if(aggregate)
+			{
+				uint8_t len;
+				while((len = receiverAgg.read(record, sizeof(record))))
+				{
+					memcpy(&createdAt, record, sizeof(createdAt) < len ? sizeof(createdAt) : len);
+					totalLatency += air.time() - createdAt;
+					received++;
+				}
+			}
+			else if(gotPayload)
+			{
+				gotPayload = false;
+				receiver.read(record, sizeof(record));
+				memcpy(&createdAt, record, sizeof(createdAt) < recordSize ? sizeof(createdAt) : recordSize);
+				totalLatency += air.time() - createdAt;
+				received++;
+			}
+		});
+
+		air.advance(50000); // 50us
+	}
+
+	printf("%s,%u,%u,%.1f,%.0f\n",
+		aggregate ? "aggregated" : "one_per_payload",
+		received,
+		senderRadio.packetsSent,
+		senderRadio.txTime / 1e6,
+		received ? (totalLatency / (double)received) / 1000.0 : 0
+	);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t records = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000;
+	recordSize = (argc > 2) ? atoi(argv[2]) : 8;
+	uint32_t interval = (argc > 3) ? strtoul(argv[3], NULL, 10) : 10000;
+	uint16_t flushTime = (argc > 4) ? atoi(argv[4]) : 30;
+
+	if(recordSize < 8)
+		recordSize = 8; // Needs to hold the creation time
+	else if(recordSize > NRF905_AGGREGATOR_MAX_RECORD)
+		recordSize = NRF905_AGGREGATOR_MAX_RECORD;
+
+	printf("mode,received,payloads,airtime_ms,latency_us\n");
+	run(false, records, interval, flushTime);
+	run(true, records, interval, flushTime);
+
+	return 0;
+}
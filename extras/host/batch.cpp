@@ -0,0 +1,176 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator config batching check)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Check that setters between .beginConfig() and .commitConfig() are sent as one SPI transaction covering only the registers they changed
+ *
+ * g++ -O2 -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/batch.cpp src/nRF905*.cpp -o batch
+ * ./batch
+ *
+ * Each case runs its setters on one radio inside .beginConfig() and .commitConfig() and on another radio without batching.
+ * The batched radio must see no SPI transactions until .commitConfig(), then exactly 1 transaction that writes the smallest
+ * contiguous range of registers covering the ones the setters touch, and nothing else.
+ * Both radios must end up with the same registers.
+ *
+ * Output is one line per case:
+ * case, setters, SPI transactions unbatched, SPI transactions batched, SPI bytes batched, registers written (bit mask), expected registers (bit mask), OK/FAIL
+ * followed by PASS or FAIL, the exit code is non-zero on FAIL
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+typedef struct {
+	const char* name;
+	uint8_t setters;
+	uint16_t dirty; // Registers the setters change
+	void (*fn)(nRF905& radio);
+} testcase_t;
+
+static const testcase_t cases[] = {
+	{"channel", 1, 0x003, [](nRF905& r){ r.setChannel(100); }},
+	{"band", 1, 0x003, [](nRF905& r){ r.setBand(NRF905_BAND_868); }},
+	{"power", 1, 0x002, [](nRF905& r){ r.setTransmitPower(NRF905_PWR_6); }},
+	{"crc", 1, 0x200, [](nRF905& r){ r.setCRC(NRF905_CRC_8); }},
+	{"address_size", 1, 0x004, [](nRF905& r){ r.setAddressSize(1, 1); }},
+	{"payload_size", 1, 0x018, [](nRF905& r){ r.setPayloadSize(16, 16); }},
+	{"listen_address", 1, 0x1E0, [](nRF905& r){ r.setListenAddress(0xB54CAB34); }},
+	{"config1", 3, 0x002, [](nRF905& r){
+		r.setAutoRetransmit(true);
+		r.setLowRxPower(true);
+		r.setTransmitPower(NRF905_PWR_n2);
+	}},
+	{"payload_size_twice", 2, 0x018, [](nRF905& r){
+		r.setPayloadSize(8, 8);
+		r.setPayloadSize(24, 24);
+	}},
+	{"channel_payload_size", 2, 0x01B, [](nRF905& r){
+		r.setChannel(200);
+		r.setPayloadSize(32, 32);
+	}},
+	{"power_crc", 2, 0x202, [](nRF905& r){
+		r.setTransmitPower(NRF905_PWR_10);
+		r.setCRC(NRF905_CRC_16);
+	}},
+	{"profile", 5, 0x21B, [](nRF905& r){
+		r.setChannel(10);
+		r.setBand(NRF905_BAND_433);
+		r.setTransmitPower(NRF905_PWR_n10);
+		r.setCRC(NRF905_CRC_DISABLE);
+		r.setPayloadSize(4, 4);
+	}},
+};
+
+static nRF905SimAir air(1);
+static nRF905SimNode batchedNode(air);
+static nRF905SimNode unbatchedNode(air);
+static nRF905SimRadio batchedRadio(batchedNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio unbatchedRadio(unbatchedNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 batched;
+static nRF905 unbatched;
+
+// Smallest contiguous range of registers covering all the dirty ones
+static uint16_t covering(uint16_t dirty)
+{
+	uint8_t first = 0;
+	while(!(dirty & (1<<first)))
+		first++;
+
+	uint8_t last = NRF905_REGISTER_COUNT - 1;
+	while(!(dirty & (1<<last)))
+		last--;
+
+	return ((1<<(last + 1)) - 1) & ~((1<<first) - 1);
+}
+
+static uint8_t bitCount(uint16_t val)
+{
+	uint8_t count = 0;
+	for(;val;val>>=1)
+		count += (val & 1);
+	return count;
+}
+
+int main()
+{
+	batchedNode.run([]{
+		SPI.begin();
+		batched.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		batched.standby();
+	});
+
+	unbatchedNode.run([]{
+		SPI.begin();
+		unbatched.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		unbatched.standby();
+	});
+
+	air.advance(5000000);
+
+	bool pass = true;
+
+	printf("case,setters,transactions_unbatched,transactions_batched,bytes_batched,written,expected,result\n");
+
+	for(uint8_t i=0;i<sizeof(cases)/sizeof(cases[0]);i++)
+	{
+		const testcase_t* c = &cases[i];
+
+		unbatchedRadio.resetCounters();
+		unbatchedNode.run([&]{ c->fn(unbatched); });
+		uint32_t unbatchedTransactions = unbatchedRadio.spiTransactions;
+
+		batchedRadio.resetCounters();
+		uint32_t beforeCommit = 0;
+		batchedNode.run([&]{
+			batched.beginConfig();
+			c->fn(batched);
+			beforeCommit = batchedRadio.spiTransactions;
+			batched.commitConfig();
+		});
+
+		uint32_t transactions = batchedRadio.spiTransactions;
+		uint32_t bytes = batchedRadio.spiBytes;
+		uint16_t written = batchedRadio.configWritten;
+		uint16_t expected = covering(c->dirty);
+
+		// Both radios must have ended up with the same registers
+		uint8_t regsBatched[NRF905_REGISTER_COUNT];
+		uint8_t regsUnbatched[NRF905_REGISTER_COUNT];
+		batchedNode.run([&]{ batched.getConfigRegisters(regsBatched); });
+		unbatchedNode.run([&]{ unbatched.getConfigRegisters(regsUnbatched); });
+
+		bool ok = (
+			beforeCommit == 0 &&
+			transactions == 1 &&
+			bytes == 1U + bitCount(expected) && // Command byte + registers
+			written == expected &&
+			memcmp(regsBatched, regsUnbatched, sizeof(regsBatched)) == 0
+		);
+
+		printf("%s,%u,%u,%u,%u,0x%03X,0x%03X,%s\n",
+			c->name,
+			c->setters,
+			unbatchedTransactions,
+			transactions,
+			bytes,
+			written,
+			expected,
+			ok ? "OK" : "FAIL"
+		);
+
+		if(!ok)
+			pass = false;
+	}
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
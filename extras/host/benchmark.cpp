@@ -0,0 +1,181 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator benchmark)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Count SPI transactions, bytes and time taken by each library call
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/benchmark.cpp src/nRF905*.cpp -o benchmark
+ * ./benchmark [spiClock]
+ *
+ * Output is CSV, one line per operation:
+ * op, SPI transactions per call, SPI bytes per call, SPI bus time per call (us), total simulated time per call including delays (us)
+ *
+ * Followed by a second CSV table with payload throughput for each payload size:
+ * op, payload size, SPI bytes per call, total simulated time per call (us), payload bytes per us of total time, payload bytes per us of SPI bus time
+ *
+ * Compare against examples/benchmark which measures the same operations on real hardware.
+ * The simulator only has digitalWrite() and digitalRead(), so NRF905_FAST_GPIO (AVR only) has to be measured with examples/benchmark.
+ * The simulated SPI bus costs the same per byte whether NRF905_SPI_BLOCK_TRANSFER is on or off, the difference between them is also only seen on real hardware.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_hop.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define ITERATIONS	100
+#define ADDR		0xB54CAB34
+
+static nRF905SimAir air(1);
+static nRF905SimNode node(air);
+static nRF905SimRadio radio(node, 6, 7, 9, 8, 4, 3, 2);
+static nRF905 transceiver;
+static nRF905Hop hop;
+
+static uint8_t buffer[NRF905_MAX_PAYLOAD];
+
+static void bench(const char* op, void (*setup)(), void (*fn)())
+{
+	uint64_t time = 0;
+
+	radio.resetCounters();
+
+	for(uint8_t i=0;i<ITERATIONS;i++)
+	{
+		// Setup isn't counted
+		uint32_t transactions = radio.spiTransactions;
+		uint32_t bytes = radio.spiBytes;
+		uint64_t busTime = radio.spiBusTime;
+		if(setup != NULL)
+			node.run(setup);
+		radio.spiTransactions = transactions;
+		radio.spiBytes = bytes;
+		radio.spiBusTime = busTime;
+
+		uint64_t start = air.time();
+		node.run(fn);
+		time += air.time() - start;
+	}
+
+	printf("%s,%.2f,%.2f,%.3f,%.3f\n",
+		op,
+		radio.spiTransactions / (double)ITERATIONS,
+		radio.spiBytes / (double)ITERATIONS,
+		(radio.spiBusTime / (double)ITERATIONS) / 1000.0,
+		(time / (double)ITERATIONS) / 1000.0
+	);
+}
+
+static uint8_t size;
+
+// Payload bytes moved per microsecond by fn for each payload size
+static void throughput(const char* op, void (*fn)())
+{
+	static const uint8_t sizes[] = {1, 2, 4, 8, 16, 24, 32};
+
+	for(uint8_t s=0;s<sizeof(sizes);s++)
+	{
+		size = sizes[s];
+
+		uint64_t time = 0;
+		radio.resetCounters();
+
+		for(uint8_t i=0;i<ITERATIONS;i++)
+		{
+			uint64_t start = air.time();
+			node.run(fn);
+			time += air.time() - start;
+		}
+
+		double timeUs = (time / (double)ITERATIONS) / 1000.0;
+		double busUs = (radio.spiBusTime / (double)ITERATIONS) / 1000.0;
+
+		printf("%s,%u,%.2f,%.3f,%.3f,%.3f\n",
+			op,
+			size,
+			radio.spiBytes / (double)ITERATIONS,
+			timeUs,
+			size / timeUs,
+			size / busUs
+		);
+	}
+}
+
+static void standby()
+{
+	transceiver.standby();
+	delay(5); // Let any transmissions finish
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t spiClock = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10000000;
+	static uint32_t clock;
+	clock = spiClock;
+
+	// Polled mode so .poll() can be measured
+	node.run([]{
+		SPI.begin();
+		transceiver.begin(SPI, clock, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		transceiver.standby();
+		hop.begin(transceiver, NRF905_BAND_433, 433100000, 434700000, 1, 0);
+	});
+	air.advance(5000000);
+
+	printf("op,transactions,bytes,bus_us,time_us\n");
+
+	bench("write_1", NULL, []{ transceiver.write(ADDR, buffer, 1); });
+	bench("write_8", NULL, []{ transceiver.write(ADDR, buffer, 8); });
+	bench("write_32", NULL, []{ transceiver.write(ADDR, buffer, 32); });
+	bench("write_newaddr_32", NULL, []{ static uint32_t addr; transceiver.write(addr++, buffer, 32); });
+	bench("writePayload_32", NULL, []{ transceiver.writePayload(buffer, 32); });
+	bench("patchPayload_2", NULL, []{ transceiver.patchPayload(buffer, 2); });
+	bench("read_1", NULL, []{ transceiver.read(buffer, 1); });
+	bench("read_32", NULL, []{ transceiver.read(buffer, 32); });
+	bench("setChannel", NULL, []{ static uint16_t ch; transceiver.setChannel(ch++ & 511); });
+	bench("setChannel_batched", NULL, []{ static uint16_t ch; transceiver.beginConfig(); transceiver.setChannel(ch++ & 511); transceiver.commitConfig(); });
+	bench("hop_next", NULL, []{ hop.next(); });
+	bench("scanChannels_16", NULL, []{ uint8_t occupancy[16]; transceiver.scanChannels(0, 15, 250, occupancy); });
+	bench("setTransmitPower", NULL, []{ transceiver.setTransmitPower(NRF905_PWR_10); });
+	bench("setPayloadSize", NULL, []{ transceiver.setPayloadSize(32, 32); });
+	bench("setListenAddress", NULL, []{ transceiver.setListenAddress(ADDR); });
+	bench("profile_separate", NULL, []{
+		transceiver.setChannel(100);
+		transceiver.setBand(NRF905_BAND_433);
+		transceiver.setTransmitPower(NRF905_PWR_6);
+		transceiver.setCRC(NRF905_CRC_16);
+		transceiver.setPayloadSize(16, 16);
+	});
+	bench("profile_batched", NULL, []{
+		transceiver.beginConfig();
+		transceiver.setChannel(100);
+		transceiver.setBand(NRF905_BAND_433);
+		transceiver.setTransmitPower(NRF905_PWR_6);
+		transceiver.setCRC(NRF905_CRC_16);
+		transceiver.setPayloadSize(16, 16);
+		transceiver.commitConfig();
+	});
+	bench("getConfigRegisters", NULL, []{ uint8_t regs[NRF905_REGISTER_COUNT]; transceiver.getConfigRegisters(regs); });
+	bench("TX_standby", standby, []{ transceiver.TX(NRF905_NEXTMODE_STANDBY, false); });
+	bench("TX_rx", standby, []{ transceiver.TX(NRF905_NEXTMODE_RX, false); });
+	bench("startTX_rx", standby, []{ transceiver.startTX(NRF905_NEXTMODE_RX, false); });
+	bench("poll", NULL, []{ transceiver.poll(); });
+	bench("mode", NULL, []{ transceiver.mode(); });
+	bench("RX_standby", NULL, []{ transceiver.RX(); transceiver.standby(); });
+	bench("airwayBusy", NULL, []{ transceiver.airwayBusy(); });
+
+	printf("\nop,size,bytes,time_us,bytes_per_us,bus_bytes_per_us\n");
+
+	throughput("write", []{ transceiver.write(ADDR, buffer, size); });
+	throughput("writePayload", []{ transceiver.writePayload(buffer, size); });
+	throughput("read", []{ transceiver.read(buffer, size); });
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator CSMA/CA example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Lots of nodes sending to one base station, retrying straight away when the channel is busy compared to nRF905Mac's random backoff
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/csma.cpp src/nRF905*.cpp -o csma
+ * ./csma [interval_ms] [seconds] [seed]
+ *
+ * Each node sends a 32 byte payload on average every interval_ms.
+ *
+ * Output is CSV, one line per fleet size and mode:
+ * nodes, mode, payloads created, payloads delivered, delivery (%), collisions on air, payloads given up on, times the channel was busy, average latency from creating a payload to it arriving (ms)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <nRF905.h>
+#include <nRF905_mac.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define MAX_NODES	40
+#define BASE_ADDR	0xA94EC554
+#define NODE_ADDR	0x10000000 // + node number
+
+typedef struct
+{
+	nRF905SimNode* mcu;
+	nRF905SimRadio* simRadio;
+	nRF905* radio;
+	nRF905Mac* mac;
+	bool pending;
+	uint64_t createdAt;
+	uint64_t nextAt;
+} node_t;
+
+static nRF905SimAir air(1);
+static node_t nodes[MAX_NODES];
+static nRF905SimNode* baseMcu;
+static nRF905 base;
+
+static uint32_t delivered;
+static uint64_t totalLatency;
+
+static void base_int_dr(){base.interrupt_dr();}
+static void base_int_am(){base.interrupt_am();}
+static void base_onRxComplete(nRF905* device)
+{
+	uint8_t payload[NRF905_MAX_PAYLOAD];
+	device->read(payload, sizeof(payload));
+
+	uint64_t createdAt;
+	memcpy(&createdAt, payload, sizeof(createdAt));
+	totalLatency += air.time() - createdAt;
+	delivered++;
+}
+
+// Exponentially distributed time until the next payload (ns)
+static uint64_t nextInterval(uint32_t interval)
+{
+	double r = (air.random() % 1000000 + 1) / 1000001.0;
+	return (uint64_t)(-log(r) * interval * 1000000.0);
+}
+
+static void run(uint8_t count, bool backoff, uint32_t interval, uint32_t seconds, uint32_t seed)
+{
+	air.setSeed(seed);
+	delivered = 0;
+	totalLatency = 0;
+
+	baseMcu->run([&]{
+		SPI.begin();
+		base.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, base_int_dr, base_int_am);
+		base.events(base_onRxComplete, NULL, NULL, NULL);
+		base.setListenAddress(BASE_ADDR);
+		base.RX();
+	});
+
+	for(uint8_t i=0;i<count;i++)
+	{
+		node_t* node = &nodes[i];
+		node->mcu->run([&]{
+			// Polled mode, the nodes only send
+			SPI.begin();
+			node->radio->begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+			node->radio->setListenAddress(NODE_ADDR + i);
+			node->radio->RX();
+			node->mac->begin(*node->radio, NODE_ADDR + i);
+			node->mac->resetStats();
+		});
+		node->pending = false;
+	}
+
+	air.advance(10000000);
+	uint32_t collisions = air.collisions;
+	uint64_t start = air.time();
+	uint64_t end = start + (seconds * 1000000000ULL);
+	for(uint8_t i=0;i<count;i++)
+		nodes[i].nextAt = start + nextInterval(interval);
+
+	uint32_t created = 0;
+	while(air.time() < end)
+	{
+		for(uint8_t i=0;i<count;i++)
+		{
+			node_t* node = &nodes[i];
+			node->mcu->run([&]{
+				// Payloads that are still waiting for the previous one to be sent are dropped
+				if(air.time() >= node->nextAt)
+				{
+					node->nextAt += nextInterval(interval);
+					if(!node->pending)
+					{
+						uint8_t payload[NRF905_MAX_PAYLOAD];
+						memset(payload, i, sizeof(payload));
+						node->createdAt = air.time();
+						memcpy(payload, &node->createdAt, sizeof(node->createdAt));
+						node->radio->write(BASE_ADDR, payload, sizeof(payload));
+						node->pending = true;
+						created++;
+
+						if(backoff)
+							node->mac->startTX(NRF905_NEXTMODE_RX);
+					}
+				}
+
+				if(backoff)
+				{
+					if(node->mac->service() != NRF905_MAC_BACKOFF)
+						node->pending = false;
+				}
+				else
+				{
+					node->radio->poll();
+					if(node->radio->service() && node->pending && node->radio->startTX(NRF905_NEXTMODE_RX, true))
+						node->pending = false;
+				}
+			});
+		}
+
+		air.advance(50000); // 50us
+	}
+
+	// Let the last payloads arrive
+	air.advance(20000000);
+
+	nRF905_mac_stats_t total;
+	memset(&total, 0, sizeof(total));
+	for(uint8_t i=0;i<count;i++)
+	{
+		nRF905_mac_stats_t stats;
+		nodes[i].mac->getStats(&stats);
+		total.failed += stats.failed;
+		total.busy += stats.busy;
+	}
+
+	printf("%u,%s,%u,%u,%.1f,%u,%u,%u,%.2f\n",
+		count,
+		backoff ? "backoff" : "retry",
+		created,
+		delivered,
+		created ? (delivered * 100.0) / created : 0,
+		air.collisions - collisions,
+		total.failed,
+		total.busy,
+		delivered ? (totalLatency / (double)delivered) / 1000000.0 : 0
+	);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t interval = (argc > 1) ? strtoul(argv[1], NULL, 10) : 500;
+	uint32_t seconds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 10;
+	uint32_t seed = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1;
+
+	baseMcu = new nRF905SimNode(air);
+	new nRF905SimRadio(*baseMcu, 6, 7, 9, 8, 4, 3, 2);
+	for(uint8_t i=0;i<MAX_NODES;i++)
+	{
+		nodes[i].mcu = new nRF905SimNode(air);
+		nodes[i].simRadio = new nRF905SimRadio(*nodes[i].mcu, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED);
+		nodes[i].radio = new nRF905();
+		nodes[i].mac = new nRF905Mac();
+	}
+
+	printf("nodes,mode,created,delivered,delivery_pct,collisions,failed,busy,latency_ms\n");
+	uint8_t counts[] = {5, 10, 20, 40};
+	for(uint8_t c=0;c<sizeof(counts);c++)
+	{
+		run(counts[c], false, interval, seconds, seed);
+		run(counts[c], true, interval, seconds, seed);
+	}
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator multi-radio example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * A gateway with two radios on one SPI bus (433MHz and 868MHz) serviced by nRF905Group, and two senders, one on each band
+ *
+ * g++ -O2 -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/group.cpp src/nRF905*.cpp -o group
+ * ./group [payloads] [seed]
+ *
+ * Both gateway radios listen on the same address, both senders send at the same time so the two radios have events at the same time.
+ * Each payload says which sender it came from. Any payload turning up on the wrong radio, any event run for the wrong radio and any
+ * payload that never arrived means the radios' states got mixed up.
+ * Runs once with both gateway radios polled and once with the 868MHz radio using interrupts.
+ *
+ * Output is one line per radio per run:
+ * mode, radio, payloads sent to it, received, received from the wrong sender, address matches, invalid
+ * followed by PASS or FAIL, the exit code is non-zero on FAIL
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_group.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define GATEWAY_ADDR	0xA94EC554
+#define PAYLOAD_SIZE	8
+#define GAP				20 // ms between payloads
+
+typedef struct
+{
+	nRF905* radio;
+	uint8_t tag;
+	uint32_t sent;
+	uint32_t received;
+	uint32_t wrong;
+	uint32_t addrMatch;
+	uint32_t invalid;
+} channel_t;
+
+static nRF905SimAir air(1);
+static nRF905SimNode gatewayNode(air);
+static nRF905SimNode sender433Node(air);
+static nRF905SimNode sender868Node(air);
+static nRF905SimNode* senderNodes[2] = {&sender433Node, &sender868Node};
+
+// Gateway radios share the SPI bus but have their own SS, CE, TXE, PWR, CD, DR and AM pins
+static nRF905SimRadio gatewayRadio433(gatewayNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio gatewayRadio868(gatewayNode, 16, 17, 19, 18, 14, 13, 12);
+static nRF905SimRadio sender433Radio(sender433Node, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED);
+static nRF905SimRadio sender868Radio(sender868Node, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED);
+
+static nRF905 gateway433;
+static nRF905 gateway868;
+static nRF905 senders[2];
+static nRF905Group group;
+static channel_t channels[2];
+
+static channel_t* channelFor(nRF905* device)
+{
+	return (device == channels[0].radio) ? &channels[0] : &channels[1];
+}
+
+static void gateway868_int_dr(){gateway868.interrupt_dr();}
+static void gateway868_int_am(){gateway868.interrupt_am();}
+
+static void onRxComplete(nRF905* device)
+{
+	channel_t* channel = channelFor(device);
+	uint8_t buffer[PAYLOAD_SIZE];
+	device->read(buffer, sizeof(buffer));
+	channel->received++;
+	if(buffer[0] != channel->tag)
+		channel->wrong++;
+}
+
+static void onRxInvalid(nRF905* device)
+{
+	channelFor(device)->invalid++;
+}
+
+static void onAddrMatch(nRF905* device)
+{
+	channelFor(device)->addrMatch++;
+}
+
+static bool run(bool mixed, uint32_t payloads)
+{
+	gatewayNode.run([&]{
+		SPI.begin();
+		gateway433.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		if(mixed)
+			gateway868.begin(SPI, 10000000, 16, 17, 19, 18, 14, 13, 12, gateway868_int_dr, gateway868_int_am);
+		else
+			gateway868.begin(SPI, 10000000, 16, 17, 19, 18, 14, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		gateway868.setBand(NRF905_BAND_868);
+
+		nRF905* radios[] = {&gateway433, &gateway868};
+		for(uint8_t i=0;i<2;i++)
+		{
+			radios[i]->events(onRxComplete, onRxInvalid, NULL, onAddrMatch);
+			radios[i]->setListenAddress(GATEWAY_ADDR);
+			radios[i]->setPayloadSize(PAYLOAD_SIZE, PAYLOAD_SIZE);
+			radios[i]->RX();
+		}
+
+		group = nRF905Group();
+		group.add(gateway433);
+		group.add(gateway868);
+	});
+
+	for(uint8_t i=0;i<2;i++)
+	{
+		senderNodes[i]->run([&]{
+			SPI.begin();
+			senders[i].begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+			senders[i].setBand(i ? NRF905_BAND_868 : NRF905_BAND_433);
+			senders[i].setPayloadSize(PAYLOAD_SIZE, PAYLOAD_SIZE);
+			senders[i].standby();
+		});
+	}
+
+	channels[0] = (channel_t){&gateway433, 0xA4, 0, 0, 0, 0, 0};
+	channels[1] = (channel_t){&gateway868, 0xB8, 0, 0, 0, 0, 0};
+
+	for(uint32_t p=0;p<payloads;p++)
+	{
+		for(uint8_t i=0;i<2;i++)
+		{
+			senderNodes[i]->run([&]{
+				uint8_t buffer[PAYLOAD_SIZE];
+				memset(buffer, channels[i].tag, sizeof(buffer));
+				memcpy(&buffer[1], &p, sizeof(p));
+				senders[i].write(GATEWAY_ADDR, buffer, sizeof(buffer));
+				if(senders[i].startTX(NRF905_NEXTMODE_STANDBY, false))
+					channels[i].sent++;
+			});
+		}
+
+		uint64_t next = air.time() + (GAP * 1000000ULL);
+		while(air.time() < next)
+		{
+			for(uint8_t i=0;i<2;i++)
+				senderNodes[i]->run([&]{ senders[i].service(); });
+			gatewayNode.run([&]{ group.poll(); });
+			air.advance(10000); // 10us
+		}
+	}
+
+	bool pass = true;
+	for(uint8_t i=0;i<2;i++)
+	{
+		channel_t* c = &channels[i];
+		printf("%s,%s,%u,%u,%u,%u,%u\n",
+			mixed ? "polled+interrupt" : "polled+polled",
+			i ? "868" : "433",
+			c->sent,
+			c->received,
+			c->wrong,
+			c->addrMatch,
+			c->invalid
+		);
+		if(c->received != c->sent || c->wrong || c->addrMatch != c->sent || c->invalid)
+			pass = false;
+	}
+
+	return pass;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t payloads = (argc > 1) ? strtoul(argv[1], NULL, 10) : 500;
+	uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+
+	air.setSeed(seed);
+
+	printf("mode,radio,sent,received,wrong,addr_match,invalid\n");
+	bool pass = run(false, payloads);
+	pass = run(true, payloads) && pass;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator link example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Send frames one way over nRF905Link with different window sizes and amounts of packet loss
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/link.cpp src/nRF905*.cpp -o link
+ * ./link [frames] [seed]
+ *
+ * Output is CSV, one line per window size and loss rate:
+ * window, loss, jitter (us), goodput (data bytes per second), frames sent, frames resent, timeouts, smoothed round trip time (us), retransmission timeout (us), frames delivered in order
+ *
+ * Then a few runs with no loss where the receiver only gets around to calling service() a random time of up to the jitter time after a frame arrives,
+ * so acknowledgements are late by different amounts.
+ * Runs with no loss must not resend anything and every run must deliver all frames in order, PASS or FAIL is printed at the end and the exit code is non-zero on FAIL.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_link.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define SENDER_ADDR		0xB54CAB34
+#define RECEIVER_ADDR	0xA94EC554
+
+static nRF905SimAir air(1);
+static nRF905SimNode senderNode(air);
+static nRF905SimNode receiverNode(air);
+static nRF905SimRadio senderRadio(senderNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio receiverRadio(receiverNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905* sender;
+static nRF905* receiver;
+static nRF905Link* senderLink;
+static nRF905Link* receiverLink;
+
+static void sender_int_dr(){sender->interrupt_dr();}
+static void sender_int_am(){sender->interrupt_am();}
+static void receiver_int_dr(){receiver->interrupt_dr();}
+static void receiver_int_am(){receiver->interrupt_am();}
+static void sender_onRxComplete(nRF905* device){(void)device; senderLink->receive();}
+
+// Receiver doesn't get around to calling service() until a random time of up to jitter after a frame arrives
+static uint32_t jitter;
+static uint64_t receiverNext;
+static void receiver_onRxComplete(nRF905* device)
+{
+	(void)device;
+	receiverLink->receive();
+	if(jitter)
+		receiverNext = air.time() + (air.random() % (jitter + 1)) * 1000ULL;
+}
+
+static bool run(uint8_t window, float loss, uint32_t jitterTime, uint32_t frames)
+{
+	jitter = jitterTime;
+
+	nRF905 senderTransceiver;
+	nRF905 receiverTransceiver;
+	nRF905Link sLink;
+	nRF905Link rLink;
+	sender = &senderTransceiver;
+	receiver = &receiverTransceiver;
+	senderLink = &sLink;
+	receiverLink = &rLink;
+
+	air.setLoss(loss);
+
+	senderNode.run([&]{
+		SPI.begin();
+		sender->begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, sender_int_dr, sender_int_am);
+		sender->setListenAddress(SENDER_ADDR);
+		sender->events(sender_onRxComplete, NULL, NULL, NULL);
+		senderLink->begin(*sender, RECEIVER_ADDR);
+		senderLink->setWindow(window);
+	});
+
+	receiverNode.run([&]{
+		SPI.begin();
+		receiver->begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, receiver_int_dr, receiver_int_am);
+		receiver->setListenAddress(RECEIVER_ADDR);
+		receiver->events(receiver_onRxComplete, NULL, NULL, NULL);
+		receiverLink->begin(*receiver, SENDER_ADDR);
+	});
+
+	air.advance(10000000);
+
+	uint32_t queued = 0;
+	uint32_t delivered = 0;
+	uint32_t inOrder = 0;
+	uint64_t start = air.time();
+	receiverNext = start;
+
+	while(delivered < frames && air.time() - start < 600000000000ULL)
+	{
+		senderNode.run([&]{
+			uint8_t data[NRF905_LINK_MAX_DATA];
+			while(queued < frames)
+			{
+				memset(data, (uint8_t)queued, sizeof(data));
+				if(!senderLink->send(data, sizeof(data)))
+					break;
+				queued++;
+			}
+			senderLink->service();
+		});
+
+		if(air.time() >= receiverNext)
+		{
+			receiverNode.run([&]{
+				receiverLink->service();
+				uint8_t data[NRF905_LINK_MAX_DATA];
+				while(receiverLink->read(data, sizeof(data)))
+				{
+					if(data[0] == (uint8_t)delivered && data[NRF905_LINK_MAX_DATA - 1] == (uint8_t)delivered)
+						inOrder++;
+					delivered++;
+				}
+			});
+		}
+
+		air.advance(50000); // 50us
+	}
+
+	double seconds = (air.time() - start) / 1e9;
+
+	nRF905_link_stats_t stats;
+	senderLink->getStats(&stats);
+
+	printf("%u,%.2f,%u,%.0f,%u,%u,%u,%u,%u,%u\n",
+		window,
+		loss,
+		jitter,
+		(delivered * NRF905_LINK_MAX_DATA) / seconds,
+		stats.dataSent,
+		stats.dataResent,
+		stats.timeouts,
+		stats.srtt,
+		stats.rto,
+		inOrder
+	);
+
+	// Without any loss nothing should ever need resending
+	return (inOrder == frames && (loss > 0 || (!stats.dataResent && !stats.timeouts)));
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = (argc > 1) ? strtoul(argv[1], NULL, 10) : 500;
+	uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+
+	static const float losses[] = {0, 0.05, 0.1, 0.2};
+
+	static const uint16_t jitters[] = {500, 1000, 2000};
+
+	bool pass = true;
+
+	printf("window,loss,jitter_us,goodput_Bps,sent,resent,timeouts,srtt_us,rto_us,in_order\n");
+
+	for(uint8_t window = 1; window <= NRF905_LINK_WINDOW; window *= 2)
+	{
+		for(uint8_t i=0;i<sizeof(losses)/sizeof(losses[0]);i++)
+		{
+			air.setSeed(seed);
+			if(!run(window, losses[i], 0, frames))
+				pass = false;
+		}
+	}
+
+	// Late acknowledgements with no loss must not cause any resends
+	for(uint8_t window = 1; window <= NRF905_LINK_WINDOW; window *= 2)
+	{
+		for(uint8_t i=0;i<sizeof(jitters)/sizeof(jitters[0]);i++)
+		{
+			air.setSeed(seed);
+			if(!run(window, 0, jitters[i], frames))
+				pass = false;
+		}
+	}
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,967 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <stdint.h>
+#include <string.h>
+#include "nRF905_sim.h"
+
+// Commands and register bits, same values as nRF905_defs.h
+#define CMD_W_CONFIG		0x00
+#define CMD_R_CONFIG		0x10
+#define CMD_W_TX_PAYLOAD	0x20
+#define CMD_R_TX_PAYLOAD	0x21
+#define CMD_W_TX_ADDRESS	0x22
+#define CMD_R_TX_ADDRESS	0x23
+#define CMD_R_RX_PAYLOAD	0x24
+#define CMD_CHAN_CONFIG		0x80
+
+#define STATUS_DR	5
+#define STATUS_AM	7
+
+#define US	1000ULL // ns per us
+
+static nRF905SimNode* currentNode;
+static nRF905SimAir* lastAir;
+static uint32_t randomState = 1;
+
+SPIClass SPI;
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x<<13;
+	x ^= x>>17;
+	x ^= x<<5;
+	*state = x;
+	return x;
+}
+
+static nRF905SimAir* air()
+{
+	if(currentNode != NULL)
+		return &currentNode->getAir();
+	return lastAir;
+}
+
+///////////////////
+// Arduino API
+///////////////////
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	if(currentNode != NULL)
+		currentNode->digitalWrite(pin, val);
+}
+
+// Reading a pin costs some simulated CPU time (1us by default, see nRF905SimAir::setCpuTime()), otherwise loops waiting on a pin (like .TX() with collision avoidance) would never end
+int digitalRead(uint8_t pin)
+{
+	if(currentNode == NULL)
+		return LOW;
+	air()->advance(air()->getCpuTime());
+	return currentNode->digitalRead(pin);
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*fn)(), int mode)
+{
+	if(currentNode != NULL)
+		currentNode->attachInterrupt(interruptNum, fn, mode);
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+	if(currentNode != NULL)
+		currentNode->detachInterrupt(interruptNum);
+}
+
+void noInterrupts()
+{
+	if(currentNode != NULL)
+		currentNode->setInterrupts(false);
+}
+
+void interrupts()
+{
+	if(currentNode != NULL)
+		currentNode->setInterrupts(true);
+}
+
+// Reading the clock costs some simulated CPU time, otherwise busy-wait loops would never end
+unsigned long micros()
+{
+	if(air() == NULL)
+		return 0;
+	air()->advance(air()->getCpuTime());
+	if(currentNode != NULL)
+		return currentNode->clock() / US;
+	return air()->time() / US;
+}
+
+unsigned long millis()
+{
+	if(air() == NULL)
+		return 0;
+	air()->advance(air()->getCpuTime());
+	if(currentNode != NULL)
+		return currentNode->clock() / (1000 * US);
+	return air()->time() / (1000 * US);
+}
+
+void delay(unsigned long ms)
+{
+	if(currentNode != NULL)
+		air()->advance(currentNode->toAirTime(ms * 1000 * US));
+	else if(air() != NULL)
+		air()->advance(ms * 1000 * US);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	if(currentNode != NULL)
+		air()->advance(currentNode->toAirTime(us * US));
+	else if(air() != NULL)
+		air()->advance(us * US);
+}
+
+void yield()
+{
+}
+
+long random(long max)
+{
+	if(max <= 0)
+		return 0;
+	return xorshift(&randomState) % max;
+}
+
+long random(long min, long max)
+{
+	if(min >= max)
+		return min;
+	return min + random(max - min);
+}
+
+void randomSeed(unsigned long seed)
+{
+	randomState = seed ? seed : 1;
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+	if(currentNode != NULL)
+	{
+		currentNode->setSpiClock(settings.clock);
+		currentNode->spiLock(true);
+	}
+}
+
+void SPIClass::endTransaction()
+{
+	if(currentNode != NULL)
+		currentNode->spiLock(false);
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+	if(currentNode != NULL)
+		return currentNode->spiTransfer(data);
+	return 0xFF;
+}
+
+void SPIClass::transfer(void* buf, size_t count)
+{
+	for(size_t i=0;i<count;i++)
+		((uint8_t*)buf)[i] = transfer(((uint8_t*)buf)[i]);
+}
+
+///////////////////
+// Radio
+///////////////////
+
+nRF905SimRadio::nRF905SimRadio(nRF905SimNode& node, uint8_t csn, uint8_t ce, uint8_t txe, uint8_t pwr, uint8_t cd, uint8_t dr, uint8_t am) :
+	node(node)
+{
+	pinCSN = csn;
+	pinCE = ce;
+	pinTXE = txe;
+	pinPWR = pwr;
+	pinCD = cd;
+	pinDR = dr;
+	pinAM = am;
+	tiedTXE = false;
+
+	// Power-on reset values from the datasheet
+	static const uint8_t defaults[10] = {0x6C, 0x00, 0x44, 0x20, 0x20, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7};
+	memcpy(config, defaults, sizeof(config));
+	memset(txAddress, 0xE7, sizeof(txAddress));
+	memset(txPayload, 0x00, sizeof(txPayload));
+	memset(rxPayload, 0x00, sizeof(rxPayload));
+
+	dr = false;
+	am = false;
+	selected = false;
+	cmd = 0xFF;
+	spiIdx = 0;
+	rxRead = 0;
+	powered = false;
+	ce = false;
+	txe = false;
+	readyAt = 0;
+	txPending = 0;
+	txPendingFromStandby = false;
+	transmitting = 0;
+	receiving = 0;
+
+	resetCounters();
+
+	node.radios.push_back(this);
+	node.air.radios.push_back(this);
+	id = node.air.radios.size();
+
+	inputsChanged();
+}
+
+void nRF905SimRadio::tieTXE(bool level)
+{
+	tiedTXE = level;
+	inputsChanged();
+}
+
+void nRF905SimRadio::resetCounters()
+{
+	spiTransactions = 0;
+	spiBytes = 0;
+	spiBusTime = 0;
+	configWritten = 0;
+	packetsSent = 0;
+	packetsReceived = 0;
+	packetsInvalid = 0;
+	txTime = 0;
+}
+
+bool nRF905SimRadio::pinLevel(uint8_t pin, bool unconnected)
+{
+	if(pin >= NRF905_SIM_PINS)
+		return unconnected;
+	return node.latch[pin];
+}
+
+uint16_t nRF905SimRadio::channel()
+{
+	return config[0] | ((config[1] & 0x01)<<8);
+}
+
+bool nRF905SimRadio::band()
+{
+	return config[1] & 0x02;
+}
+
+uint8_t nRF905SimRadio::rxAddrWidth()
+{
+	return config[2] & 0x07;
+}
+
+uint8_t nRF905SimRadio::txAddrWidth()
+{
+	return (config[2]>>4) & 0x07;
+}
+
+uint8_t nRF905SimRadio::rxPayloadWidth()
+{
+	return config[3] & 0x3F;
+}
+
+uint8_t nRF905SimRadio::txPayloadWidth()
+{
+	return config[4] & 0x3F;
+}
+
+uint8_t nRF905SimRadio::crcBits()
+{
+	if(!(config[9] & 0x40))
+		return 0;
+	return (config[9] & 0x80) ? 16 : 8;
+}
+
+bool nRF905SimRadio::inRX()
+{
+	return powered && ce && !txe && !transmitting && !txPending && node.air.now >= readyAt;
+}
+
+bool nRF905SimRadio::inTX()
+{
+	return transmitting != 0;
+}
+
+void nRF905SimRadio::setDR(bool val)
+{
+	if(dr == val)
+		return;
+	dr = val;
+	if(pinDR < NRF905_SIM_PINS)
+		node.radioPinChanged(pinDR, !val, val);
+}
+
+void nRF905SimRadio::setAM(bool val)
+{
+	if(am == val)
+		return;
+	am = val;
+	if(pinAM < NRF905_SIM_PINS)
+		node.radioPinChanged(pinAM, !val, val);
+}
+
+void nRF905SimRadio::clearRX()
+{
+	receiving = 0;
+	memset(rxPayload, 0x00, sizeof(rxPayload));
+	setDR(false);
+	setAM(false);
+}
+
+// CE, TXE or PWR changed
+void nRF905SimRadio::inputsChanged()
+{
+	bool wasPowered = powered;
+	bool wasCE = ce;
+	bool wasTXE = txe;
+
+	powered = pinLevel(pinPWR, true);
+	ce = pinLevel(pinCE, true);
+	txe = pinLevel(pinTXE, tiedTXE);
+
+	nRF905SimAir& air = node.air;
+
+	if(!powered)
+	{
+		if(wasPowered)
+		{
+			// Power-down cancels everything
+			txPending = 0;
+			if(transmitting)
+			{
+				nRF905SimAir::transmission_t* t = air.findTransmission(transmitting);
+				if(t != NULL)
+					t->collided = true; // Cut off half way through, receivers will see a bad packet
+				transmitting = 0;
+			}
+			clearRX();
+		}
+		return;
+	}
+
+	if(!wasPowered)
+		readyAt = air.now + (NRF905_SIM_POWERUP_TIME * US);
+
+	if(!ce)
+	{
+		// Standby, any ongoing transmission will finish first
+		if(receiving)
+		{
+			receiving = 0;
+			if(!dr)
+				setAM(false);
+		}
+		return;
+	}
+
+	bool enteredMode = !wasPowered || !wasCE || (wasTXE != txe);
+	if(!enteredMode)
+		return;
+
+	if(txe)
+	{
+		if(!transmitting && !txPending)
+		{
+			clearRX();
+
+			uint64_t start = air.now + (NRF905_SIM_SETTLE_TIME * US);
+			if(readyAt > start)
+				start = readyAt;
+
+			txPendingFromStandby = !wasCE || !wasPowered;
+			uint32_t pending = ++air.seq;
+			txPending = pending;
+			air.schedule(start, [this, pending]() {
+				if(txPending == pending)
+					startTX();
+			});
+		}
+	}
+	else
+	{
+		// Leaving TX mode before the radio has settled corrupts the transmission if it was started from standby
+		if(txPending && txPendingFromStandby)
+			txPending = 0;
+
+		if(!transmitting)
+			clearRX();
+
+		uint64_t ready = air.now + (NRF905_SIM_SETTLE_TIME * US);
+		if(ready > readyAt)
+			readyAt = ready;
+	}
+}
+
+void nRF905SimRadio::startTX()
+{
+	txPending = 0;
+	node.air.transmit(this);
+}
+
+void nRF905SimRadio::finishTX()
+{
+	transmitting = 0;
+	packetsSent++;
+
+	if(!powered)
+		return;
+
+	if(ce && txe)
+	{
+		// Still in TX mode
+		if(config[1] & 0x20) // Auto-retransmit
+			startTX();
+		else
+			setDR(true);
+	}
+	else if(!ce)
+		setDR(true); // Standby
+	else
+		clearRX(); // Went to RX mode while transmitting, DR doesn't pulse
+}
+
+///////////////////
+// MCU
+///////////////////
+
+nRF905SimNode::nRF905SimNode(nRF905SimAir& air) :
+	air(air)
+{
+	for(uint8_t i=0;i<NRF905_SIM_PINS;i++)
+	{
+		latch[i] = false;
+		isr[i] = NULL;
+		isrMode[i] = 0;
+	}
+	interruptsEnabled = true;
+	inIsr = false;
+	spiLocked = false;
+	spiClock = 4000000;
+	clockDrift = 0;
+}
+
+nRF905SimNode* nRF905SimNode::current()
+{
+	return currentNode;
+}
+
+nRF905SimAir& nRF905SimNode::getAir()
+{
+	return air;
+}
+
+void nRF905SimNode::setClockDrift(int32_t ppm)
+{
+	clockDrift = ppm;
+}
+
+uint64_t nRF905SimNode::clock()
+{
+	uint64_t time = air.time();
+	return time + (((int64_t)time * clockDrift) / 1000000);
+}
+
+uint64_t nRF905SimNode::toAirTime(uint64_t ns)
+{
+	return (ns * 1000000) / (1000000 + clockDrift);
+}
+
+void nRF905SimNode::run(std::function<void()> fn)
+{
+	nRF905SimNode* prev = currentNode;
+	currentNode = this;
+	fn();
+	currentNode = prev;
+}
+
+void nRF905SimNode::digitalWrite(uint8_t pin, uint8_t val)
+{
+	if(pin >= NRF905_SIM_PINS)
+		return;
+
+	bool level = (val != LOW);
+	latch[pin] = level;
+
+	for(size_t i=0;i<radios.size();i++)
+	{
+		nRF905SimRadio* radio = radios[i];
+		if(radio->pinCSN == pin)
+		{
+			if(!level && !radio->selected)
+			{
+				radio->selected = true;
+				radio->spiIdx = 0;
+				radio->rxRead = 0;
+				radio->spiTransactions++;
+			}
+			else if(level && radio->selected)
+			{
+				radio->selected = false;
+
+				// Reading the whole payload clears DR and AM
+				if(radio->cmd == CMD_R_RX_PAYLOAD && radio->dr && radio->rxRead >= radio->rxPayloadWidth())
+				{
+					radio->setDR(false);
+					radio->setAM(false);
+				}
+			}
+		}
+		else if(radio->pinCE == pin || radio->pinTXE == pin || radio->pinPWR == pin)
+			radio->inputsChanged();
+	}
+}
+
+int nRF905SimNode::digitalRead(uint8_t pin)
+{
+	if(pin >= NRF905_SIM_PINS)
+		return LOW;
+
+	for(size_t i=0;i<radios.size();i++)
+	{
+		nRF905SimRadio* radio = radios[i];
+		if(radio->pinDR == pin)
+			return radio->dr;
+		if(radio->pinAM == pin)
+			return radio->am;
+		if(radio->pinCD == pin)
+			return radio->powered && radio->ce && !radio->txe && air.carrier(radio->channel(), radio->band());
+	}
+
+	return latch[pin];
+}
+
+void nRF905SimNode::attachInterrupt(uint8_t pin, void (*fn)(), int mode)
+{
+	if(pin >= NRF905_SIM_PINS)
+		return;
+	isr[pin] = fn;
+	isrMode[pin] = mode;
+}
+
+void nRF905SimNode::detachInterrupt(uint8_t pin)
+{
+	if(pin >= NRF905_SIM_PINS)
+		return;
+	isr[pin] = NULL;
+}
+
+void nRF905SimNode::setInterrupts(bool enabled)
+{
+	if(inIsr)
+		return;
+	interruptsEnabled = enabled;
+	deliverPendingIsr();
+}
+
+void nRF905SimNode::spiLock(bool locked)
+{
+	spiLocked = locked;
+	deliverPendingIsr();
+}
+
+void nRF905SimNode::setSpiClock(uint32_t clock)
+{
+	if(clock)
+		spiClock = clock;
+}
+
+void nRF905SimNode::radioPinChanged(uint8_t pin, bool oldLevel, bool newLevel)
+{
+	if(isr[pin] == NULL)
+		return;
+
+	bool fire = false;
+	if(isrMode[pin] == CHANGE)
+		fire = (oldLevel != newLevel);
+	else if(isrMode[pin] == RISING)
+		fire = (!oldLevel && newLevel);
+	else if(isrMode[pin] == FALLING)
+		fire = (oldLevel && !newLevel);
+
+	if(!fire)
+		return;
+
+	pendingIsr.push_back(pin);
+	deliverPendingIsr();
+}
+
+// Interrupts are held back while interrupts are disabled, an ISR is already running or an SPI transaction is in progress (SPI.usingInterrupt())
+void nRF905SimNode::deliverPendingIsr()
+{
+	while(!pendingIsr.empty() && interruptsEnabled && !inIsr && !spiLocked)
+	{
+		uint8_t pin = pendingIsr.front();
+		pendingIsr.erase(pendingIsr.begin());
+
+		if(isr[pin] == NULL)
+			continue;
+
+		nRF905SimNode* prev = currentNode;
+		currentNode = this;
+		inIsr = true;
+		isr[pin]();
+		inIsr = false;
+		currentNode = prev;
+	}
+}
+
+nRF905SimRadio* nRF905SimNode::selectedRadio()
+{
+	for(size_t i=0;i<radios.size();i++)
+	{
+		if(radios[i]->selected)
+			return radios[i];
+	}
+	return NULL;
+}
+
+uint8_t nRF905SimNode::spiTransfer(uint8_t data)
+{
+	uint64_t byteTime = (8ULL * 1000000000ULL) / spiClock;
+	nRF905SimRadio* radio = selectedRadio();
+
+	air.advance(byteTime);
+
+	if(radio == NULL)
+		return 0xFF; // MISO pulled up
+
+	radio->spiBytes++;
+	radio->spiBusTime += byteTime;
+
+	uint8_t out = 0x00;
+
+	if(radio->spiIdx == 0)
+	{
+		radio->cmd = data;
+		out = (radio->am<<STATUS_AM) | (radio->dr<<STATUS_DR);
+		if((data & 0xF0) == CMD_CHAN_CONFIG)
+		{
+			radio->config[1] = (radio->config[1] & 0xF0) | (data & 0x0F);
+			radio->configWritten |= (1<<1);
+		}
+	}
+	else
+	{
+		uint8_t i = radio->spiIdx - 1;
+		uint8_t cmd = radio->cmd;
+
+		if((cmd & 0xF0) == CMD_W_CONFIG)
+		{
+			uint8_t reg = (cmd & 0x0F) + i;
+			if(reg < sizeof(radio->config))
+			{
+				radio->config[reg] = data;
+				radio->configWritten |= (1<<reg);
+			}
+		}
+		else if((cmd & 0xF0) == CMD_R_CONFIG)
+		{
+			uint8_t reg = (cmd & 0x0F) + i;
+			if(reg < sizeof(radio->config))
+				out = radio->config[reg];
+		}
+		else if((cmd & 0xF0) == CMD_CHAN_CONFIG)
+		{
+			if(i == 0)
+			{
+				radio->config[0] = data;
+				radio->configWritten |= (1<<0);
+			}
+		}
+		else if(cmd == CMD_W_TX_PAYLOAD)
+		{
+			if(i < sizeof(radio->txPayload))
+				radio->txPayload[i] = data;
+		}
+		else if(cmd == CMD_R_TX_PAYLOAD)
+		{
+			if(i < sizeof(radio->txPayload))
+				out = radio->txPayload[i];
+		}
+		else if(cmd == CMD_W_TX_ADDRESS)
+		{
+			if(i < sizeof(radio->txAddress))
+				radio->txAddress[i] = data;
+		}
+		else if(cmd == CMD_R_TX_ADDRESS)
+		{
+			if(i < sizeof(radio->txAddress))
+				out = radio->txAddress[i];
+		}
+		else if(cmd == CMD_R_RX_PAYLOAD)
+		{
+			if(i < sizeof(radio->rxPayload))
+				out = radio->rxPayload[i];
+			radio->rxRead = i + 1;
+		}
+	}
+
+	if(radio->spiIdx < 255)
+		radio->spiIdx++;
+
+	return out;
+}
+
+///////////////////
+// Air
+///////////////////
+
+nRF905SimAir::nRF905SimAir(uint32_t seed)
+{
+	now = 0;
+	seq = 0;
+	nextTxId = 0;
+	rng = seed ? seed : 1;
+	lossRate = 0;
+	corruptRate = 0;
+	latency = 0;
+	cpuTime = 1 * US;
+	collisions = 0;
+	lastAir = this;
+}
+
+void nRF905SimAir::setSeed(uint32_t seed)
+{
+	rng = seed ? seed : 1;
+}
+
+void nRF905SimAir::setLoss(float rate)
+{
+	lossRate = rate;
+}
+
+void nRF905SimAir::setCorruption(float rate)
+{
+	corruptRate = rate;
+}
+
+void nRF905SimAir::setLatency(uint32_t us)
+{
+	latency = us * US;
+}
+
+void nRF905SimAir::setCpuTime(uint32_t ns)
+{
+	cpuTime = ns ? ns : 1;
+}
+
+uint32_t nRF905SimAir::getCpuTime()
+{
+	return cpuTime;
+}
+
+uint64_t nRF905SimAir::time()
+{
+	return now;
+}
+
+uint32_t nRF905SimAir::random()
+{
+	return xorshift(&rng);
+}
+
+bool nRF905SimAir::chance(float probability)
+{
+	if(probability <= 0)
+		return false;
+	return (random() % 1000000) < (uint32_t)(probability * 1000000);
+}
+
+void nRF905SimAir::schedule(uint64_t at, std::function<void()> fn)
+{
+	event_t e;
+	e.time = at;
+	e.seq = ++seq;
+	e.fn = fn;
+	events.push(e);
+}
+
+void nRF905SimAir::advance(uint64_t ns)
+{
+	advanceTo(now + ns);
+}
+
+void nRF905SimAir::advanceTo(uint64_t ns)
+{
+	while(!events.empty() && events.top().time <= ns)
+	{
+		event_t e = events.top();
+		events.pop();
+		if(e.time > now)
+			now = e.time;
+		e.fn();
+	}
+
+	if(ns > now)
+		now = ns;
+}
+
+bool nRF905SimAir::carrier(uint16_t channel, bool band)
+{
+	for(size_t i=0;i<onAir.size();i++)
+	{
+		transmission_t& t = onAir[i];
+		if(t.channel == channel && t.band == band && t.start <= now && now < t.end)
+			return true;
+	}
+	return false;
+}
+
+nRF905SimAir::transmission_t* nRF905SimAir::findTransmission(uint32_t txId)
+{
+	for(size_t i=0;i<onAir.size();i++)
+	{
+		if(onAir[i].id == txId)
+			return &onAir[i];
+	}
+	return NULL;
+}
+
+void nRF905SimAir::transmit(nRF905SimRadio* sender)
+{
+	// Forget about old transmissions
+	for(size_t i=0;i<onAir.size();)
+	{
+		if(onAir[i].end + latency + (1000 * US) < now)
+			onAir.erase(onAir.begin() + i);
+		else
+			i++;
+	}
+
+	transmission_t t;
+	t.id = ++nextTxId;
+	t.sender = sender;
+	t.channel = sender->channel();
+	t.band = sender->band();
+	t.addrWidth = sender->txAddrWidth();
+	t.payloadWidth = sender->txPayloadWidth();
+	t.crcBits = sender->crcBits();
+	memcpy(t.addr, sender->txAddress, sizeof(t.addr));
+	memcpy(t.payload, sender->txPayload, sizeof(t.payload));
+	t.collided = false;
+
+	uint32_t bits = NRF905_SIM_PREAMBLE_BITS + ((t.addrWidth + t.payloadWidth) * 8) + t.crcBits;
+	t.start = now;
+	t.end = now + (bits * NRF905_SIM_BIT_TIME * US);
+
+	for(size_t i=0;i<onAir.size();i++)
+	{
+		transmission_t& other = onAir[i];
+		if(other.channel == t.channel && other.band == t.band && other.end > now)
+		{
+			other.collided = true;
+			t.collided = true;
+			collisions++;
+		}
+	}
+
+	onAir.push_back(t);
+
+	sender->transmitting = t.id;
+	sender->txTime += t.end - t.start;
+
+	uint32_t txId = t.id;
+	schedule(t.end, [this, txId, sender]() {
+		if(sender->transmitting == txId)
+			sender->finishTX();
+	});
+
+	uint64_t addrTime = t.start + latency + ((NRF905_SIM_PREAMBLE_BITS + (t.addrWidth * 8)) * NRF905_SIM_BIT_TIME * US);
+	for(size_t i=0;i<radios.size();i++)
+	{
+		nRF905SimRadio* rx = radios[i];
+		if(rx == sender)
+			continue;
+		schedule(addrTime, [this, txId, rx]() {
+			addressCheck(txId, rx);
+		});
+	}
+}
+
+void nRF905SimAir::addressCheck(uint32_t txId, nRF905SimRadio* rx)
+{
+	transmission_t* t = findTransmission(txId);
+	if(t == NULL)
+		return;
+
+	if(!rx->inRX() || rx->receiving || rx->dr)
+		return;
+	if(rx->channel() != t->channel || rx->band() != t->band)
+		return;
+	if(rx->rxAddrWidth() != t->addrWidth || memcmp(&rx->config[5], t->addr, t->addrWidth) != 0)
+		return;
+	if(chance(lossRate))
+		return;
+
+	rx->receiving = txId;
+	rx->setAM(true);
+
+	schedule(t->end + latency, [this, txId]() {
+		endOfFrame(txId);
+	});
+}
+
+void nRF905SimAir::endOfFrame(uint32_t txId)
+{
+	transmission_t* t = findTransmission(txId);
+	if(t == NULL)
+		return;
+
+	for(size_t i=0;i<radios.size();i++)
+	{
+		nRF905SimRadio* rx = radios[i];
+		if(rx->receiving != txId)
+			continue;
+
+		rx->receiving = 0;
+
+		bool ok = !t->collided && rx->rxPayloadWidth() == t->payloadWidth && rx->crcBits() == t->crcBits && !chance(corruptRate);
+		bool deliver = ok;
+
+		uint8_t payload[32];
+		memcpy(payload, t->payload, sizeof(payload));
+
+		// Without CRC the radio can't tell that the payload is bad
+		if(!ok && rx->crcBits() == 0)
+		{
+			payload[random() % sizeof(payload)] ^= 1<<(random() % 8);
+			deliver = true;
+		}
+
+		if(deliver)
+		{
+			memcpy(rx->rxPayload, payload, sizeof(rx->rxPayload));
+			rx->packetsReceived++;
+			rx->setDR(true);
+		}
+		else
+		{
+			rx->packetsInvalid++;
+			rx->setAM(false);
+		}
+	}
+}
@@ -0,0 +1,302 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Simulated nRF905 radios for running the library on a PC (Linux, g++)
+ *
+ * This directory provides its own Arduino.h and SPI.h which route digitalWrite(), digitalRead(), attachInterrupt(), SPI etc
+ * to simulated MCUs (nRF905SimNode), each with one or more simulated nRF905 radios (nRF905SimRadio) attached.
+ * The radios share a simulated air medium (nRF905SimAir) with configurable packet loss, corruption and latency.
+ * Overlapping transmissions on the same frequency collide.
+ *
+ * Time is simulated and only moves forward when the code calls delay(), delayMicroseconds(), micros(), millis(), digitalRead(),
+ * transfers bytes over SPI or when nRF905SimAir::advance() is called, so results are the same on every run for the same seed.
+ *
+ * Build with the unmodified library sources:
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp src/nRF905*.cpp your_program.cpp -o your_program
+ *
+ * See ping.cpp for an example.
+ */
+
+#ifndef NRF905_SIM_H_
+#define NRF905_SIM_H_
+
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+class nRF905SimAir;
+class nRF905SimNode;
+
+#define NRF905_SIM_PINS			64 ///< Number of GPIO pins on each simulated MCU
+#define NRF905_SIM_BIT_TIME		20 ///< Microseconds per bit on air (50kbps Manchester encoded)
+#define NRF905_SIM_PREAMBLE_BITS	10 ///< Preamble length in bits
+#define NRF905_SIM_SETTLE_TIME	650 ///< Standby to TX/RX settle time in microseconds
+#define NRF905_SIM_POWERUP_TIME	3000 ///< Power-down to standby time in microseconds
+
+/**
+* @brief Simulated nRF905 radio
+*/
+class nRF905SimRadio
+{
+	friend class nRF905SimAir;
+	friend class nRF905SimNode;
+
+private:
+	nRF905SimNode& node;
+	uint32_t id;
+
+	// MCU pins the radio is wired to (255 = not connected)
+	uint8_t pinCSN;
+	uint8_t pinCE;
+	uint8_t pinTXE;
+	uint8_t pinPWR;
+	uint8_t pinCD;
+	uint8_t pinDR;
+	uint8_t pinAM;
+	bool tiedTXE; // Level of TXE if not connected to the MCU
+
+	// Registers
+	uint8_t config[10];
+	uint8_t txAddress[4];
+	uint8_t txPayload[32];
+	uint8_t rxPayload[32];
+
+	// Output pins
+	bool dr;
+	bool am;
+
+	// SPI
+	bool selected;
+	uint8_t cmd;
+	uint8_t spiIdx;
+	uint8_t rxRead;
+
+	// Mode
+	bool powered;
+	bool ce;
+	bool txe;
+	uint64_t readyAt; // When power-up or RX/TX settling finishes (ns)
+	uint32_t txPending; // Scheduled transmission start sequence number (0 = none)
+	bool txPendingFromStandby;
+	uint32_t transmitting; // Transmission ID currently on air (0 = none)
+	uint32_t receiving; // Transmission ID currently being received (0 = none)
+
+	bool pinLevel(uint8_t pin, bool unconnected);
+	void inputsChanged();
+	void startTX();
+	void finishTX();
+	void clearRX();
+	void setDR(bool val);
+	void setAM(bool val);
+	uint16_t channel();
+	bool band();
+	uint8_t txAddrWidth();
+	uint8_t rxAddrWidth();
+	uint8_t txPayloadWidth();
+	uint8_t rxPayloadWidth();
+	uint8_t crcBits();
+
+public:
+/**
+* @brief Attach a radio to an MCU
+*
+* Pins are the MCU pin numbers the radio is connected to. Use 255 (NRF905_PIN_UNUSED) for pins that are not connected,
+* unconnected CE and PWR pins are tied to VCC and unconnected TXE pins are tied to GND (see .tieTXE()).
+*/
+	nRF905SimRadio(nRF905SimNode& node, uint8_t csn, uint8_t ce, uint8_t txe, uint8_t pwr, uint8_t cd, uint8_t dr, uint8_t am);
+
+/**
+* @brief Level of the TXE pin if it is not connected to the MCU (default false = GND)
+*/
+	void tieTXE(bool level);
+
+	bool inRX(); ///< Powered up, ready and in RX mode
+	bool inTX(); ///< Currently transmitting a packet
+
+	// Counters
+	uint32_t spiTransactions; ///< Number of chip select cycles
+	uint32_t spiBytes; ///< Number of bytes transferred over SPI
+	uint64_t spiBusTime; ///< Time spent transferring bytes over SPI (ns)
+	uint16_t configWritten; ///< Bit mask of config registers written by W_CONFIG or CHAN_CONFIG
+	uint32_t packetsSent; ///< Number of packets transmitted
+	uint32_t packetsReceived; ///< Number of packets received with DR asserted
+	uint32_t packetsInvalid; ///< Number of packets that matched the address but failed
+	uint64_t txTime; ///< Time spent transmitting packets (ns)
+
+	void resetCounters();
+};
+
+/**
+* @brief Simulated MCU
+*/
+class nRF905SimNode
+{
+	friend class nRF905SimAir;
+	friend class nRF905SimRadio;
+
+private:
+	nRF905SimAir& air;
+	std::vector<nRF905SimRadio*> radios;
+	bool latch[NRF905_SIM_PINS];
+	void (*isr[NRF905_SIM_PINS])();
+	int isrMode[NRF905_SIM_PINS];
+	std::vector<uint8_t> pendingIsr;
+	bool interruptsEnabled;
+	bool inIsr;
+	bool spiLocked;
+	uint32_t spiClock;
+	int32_t clockDrift;
+
+	void radioPinChanged(uint8_t pin, bool oldLevel, bool newLevel);
+	void deliverPendingIsr();
+	nRF905SimRadio* selectedRadio();
+
+public:
+	nRF905SimNode(nRF905SimAir& air);
+
+/**
+* @brief Run some code as this MCU
+*
+* All Arduino functions called by \p fn will act on this MCU and its radios.
+*/
+	void run(std::function<void()> fn);
+
+/**
+* @brief The MCU that the Arduino functions are currently acting on
+*/
+	static nRF905SimNode* current();
+
+	// Arduino functions for this MCU
+	void digitalWrite(uint8_t pin, uint8_t val);
+	int digitalRead(uint8_t pin);
+	void attachInterrupt(uint8_t pin, void (*fn)(), int mode);
+	void detachInterrupt(uint8_t pin);
+	void setInterrupts(bool enabled);
+	void spiLock(bool locked);
+	void setSpiClock(uint32_t clock);
+	uint8_t spiTransfer(uint8_t data);
+
+	nRF905SimAir& getAir();
+
+/**
+* @brief Make this MCU's clock run fast or slow compared to the simulated time
+*
+* Changes what micros(), millis(), delay() and delayMicroseconds() see, like a real crystal that's a bit off frequency (typically +/-20 to 100ppm).
+*
+* @param [ppm] Parts per million, positive runs fast
+*/
+	void setClockDrift(int32_t ppm);
+
+/**
+* @brief This MCU's clock (ns)
+*/
+	uint64_t clock();
+
+/**
+* @brief Convert a duration on this MCU's clock into simulated time (ns)
+*/
+	uint64_t toAirTime(uint64_t ns);
+};
+
+/**
+* @brief Shared air medium and simulated clock
+*/
+class nRF905SimAir
+{
+	friend class nRF905SimRadio;
+	friend class nRF905SimNode;
+
+private:
+	typedef struct
+	{
+		uint64_t time;
+		uint32_t seq;
+		std::function<void()> fn;
+	} event_t;
+
+	struct eventCompare
+	{
+		bool operator()(const event_t& a, const event_t& b) const
+		{
+			if(a.time != b.time)
+				return a.time > b.time;
+			return a.seq > b.seq;
+		}
+	};
+
+	typedef struct
+	{
+		uint32_t id;
+		nRF905SimRadio* sender;
+		uint16_t channel;
+		bool band;
+		uint64_t start;
+		uint64_t end;
+		uint8_t addrWidth;
+		uint8_t payloadWidth;
+		uint8_t crcBits;
+		uint8_t addr[4];
+		uint8_t payload[32];
+		bool collided;
+	} transmission_t;
+
+	std::priority_queue<event_t, std::vector<event_t>, eventCompare> events;
+	std::vector<transmission_t> onAir;
+	std::vector<nRF905SimRadio*> radios;
+	uint64_t now; // ns
+	uint32_t seq;
+	uint32_t nextTxId;
+	uint32_t rng;
+	float lossRate;
+	float corruptRate;
+	uint32_t latency; // ns
+	uint32_t cpuTime; // ns
+
+	void schedule(uint64_t at, std::function<void()> fn);
+	void transmit(nRF905SimRadio* sender);
+	void addressCheck(uint32_t txId, nRF905SimRadio* rx);
+	void endOfFrame(uint32_t txId);
+	transmission_t* findTransmission(uint32_t txId);
+	bool chance(float probability);
+
+public:
+/**
+* @brief Create the air medium
+*
+* @param [seed] Random seed for packet loss and corruption
+*/
+	nRF905SimAir(uint32_t seed);
+
+	void setSeed(uint32_t seed); ///< Restart the random number generator
+	void setLoss(float rate); ///< Probability of a receiver missing a packet completely (0.0 - 1.0)
+	void setCorruption(float rate); ///< Probability of a receiver getting a corrupted packet (0.0 - 1.0)
+	void setLatency(uint32_t us); ///< Extra delay between sending and receiving
+	void setCpuTime(uint32_t ns); ///< Simulated CPU time used by each micros(), millis() and digitalRead() call (default 1000ns), lower it when running lots of nodes since every node's calls add up
+	uint32_t getCpuTime();
+
+/**
+* @brief Move the simulated clock forward, running any radio events that happen in that time
+*/
+	void advance(uint64_t ns);
+
+/**
+* @brief Run radio events until the clock reaches \p ns
+*/
+	void advanceTo(uint64_t ns);
+
+	uint64_t time(); ///< Current simulated time (ns)
+	bool carrier(uint16_t channel, bool band); ///< See if anything is transmitting on a frequency
+	uint32_t random(); ///< Next number from the simulator's random number generator
+
+	// Counters
+	uint32_t collisions; ///< Number of times a transmission overlapped another transmission on the same frequency
+};
+
+#endif /* NRF905_SIM_H_ */
@@ -0,0 +1,166 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator ping example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Ping client and server running on 2 simulated MCUs in one process, same as the ping_client and ping_server examples
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/ping.cpp src/nRF905*.cpp -o ping
+ * ./ping [seed] [loss]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define CLIENT_ADDR	0xB54CAB34
+#define SERVER_ADDR	0xA94EC554
+#define PINGS		1000
+#define TIMEOUT		50 // ms
+
+static nRF905SimAir air(1);
+static nRF905SimNode clientNode(air);
+static nRF905SimNode serverNode(air);
+
+// Same wiring as the examples: SS 6, CE 7, TXE 9, PWR 8, CD 4, DR 3, AM 2
+static nRF905SimRadio clientRadio(clientNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio serverRadio(serverNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 client;
+static nRF905 server;
+
+static volatile bool clientGotReply;
+static volatile bool serverGotPing;
+
+static void client_int_dr(){client.interrupt_dr();}
+static void client_int_am(){client.interrupt_am();}
+static void server_int_dr(){server.interrupt_dr();}
+static void server_int_am(){server.interrupt_am();}
+
+static void client_onRxComplete(nRF905* device)
+{
+	(void)device;
+	clientGotReply = true;
+}
+
+static void server_onRxComplete(nRF905* device)
+{
+	serverGotPing = true;
+	device->standby();
+}
+
+static void setupRadio(nRF905& radio, uint32_t addr, void (*dr)(), void (*am)())
+{
+	SPI.begin();
+	radio.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, dr, am);
+	radio.setListenAddress(addr);
+	radio.RX();
+}
+
+// Server main loop, never blocks
+static void serverLoop()
+{
+	server.service();
+
+	if(!serverGotPing)
+		return;
+	serverGotPing = false;
+
+	uint8_t buffer[NRF905_MAX_PAYLOAD];
+	server.read(buffer, sizeof(buffer));
+	for(uint8_t i=0;i<sizeof(buffer);i++)
+		buffer[i]++;
+
+	server.write(CLIENT_ADDR, buffer, sizeof(buffer));
+	server.startTX(NRF905_NEXTMODE_RX, false);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t seed = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1;
+	float loss = (argc > 2) ? atof(argv[2]) : 0.1;
+
+	air.setSeed(seed);
+	air.setLoss(loss);
+
+	clientNode.run([]{
+		setupRadio(client, CLIENT_ADDR, client_int_dr, client_int_am);
+		client.events(client_onRxComplete, NULL, NULL, NULL);
+	});
+
+	serverNode.run([]{
+		setupRadio(server, SERVER_ADDR, server_int_dr, server_int_am);
+		server.events(server_onRxComplete, NULL, NULL, NULL);
+	});
+
+	uint32_t replies = 0;
+	uint32_t timeouts = 0;
+	uint32_t badData = 0;
+	uint64_t totalRtt = 0;
+
+	for(uint32_t ping=0;ping<PINGS;ping++)
+	{
+		uint8_t buffer[NRF905_MAX_PAYLOAD];
+		uint64_t start = air.time();
+
+		clientNode.run([&]{
+			memset(buffer, (uint8_t)ping, sizeof(buffer));
+			clientGotReply = false;
+			client.write(SERVER_ADDR, buffer, sizeof(buffer));
+			while(!client.TX(NRF905_NEXTMODE_RX, true))
+				delayMicroseconds(100);
+		});
+
+		// Run both MCUs until the reply arrives or times out
+		bool timedOut = false;
+		while(!clientGotReply)
+		{
+			serverNode.run(serverLoop);
+			air.advance(10000); // 10us
+
+			if(air.time() - start > TIMEOUT * 1000000ULL)
+			{
+				timedOut = true;
+				break;
+			}
+		}
+
+		if(timedOut)
+		{
+			timeouts++;
+			continue;
+		}
+
+		totalRtt += air.time() - start;
+		replies++;
+
+		clientNode.run([&]{
+			client.read(buffer, sizeof(buffer));
+		});
+
+		for(uint8_t i=0;i<sizeof(buffer);i++)
+		{
+			if(buffer[i] != (uint8_t)(ping + 1))
+			{
+				badData++;
+				break;
+			}
+		}
+	}
+
+	printf("seed %u, loss %.2f\n", seed, loss);
+	printf("pings %u, replies %u, timeouts %u, bad %u\n", PINGS, replies, timeouts, badData);
+	if(replies)
+		printf("average round trip %.1f us\n", (totalRtt / (double)replies) / 1000.0);
+	printf("client: sent %u, received %u, invalid %u, spi bytes %u\n", clientRadio.packetsSent, clientRadio.packetsReceived, clientRadio.packetsInvalid, clientRadio.spiBytes);
+	printf("server: sent %u, received %u, invalid %u, spi bytes %u\n", serverRadio.packetsSent, serverRadio.packetsReceived, serverRadio.packetsInvalid, serverRadio.spiBytes);
+	printf("collisions %u\n", air.collisions);
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator channel scan check)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Check that .scanChannels() finds a busy channel, including when called between .beginConfig() and .commitConfig(), and time a full sweep
+ *
+ * g++ -O2 -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/scan.cpp src/nRF905*.cpp -o scan
+ * ./scan [dwell]
+ *
+ * Another radio sends a carrier on channel BUSY_CHANNEL the whole time (auto-retransmit).
+ * Each case scans channels 0 - 511 and must see that channel as busy and every other channel as quiet, then the scanning radio must be back on its own channel.
+ * The batched case sets the payload size between .beginConfig() and .scanChannels(), that change must have reached the radio by the time the scan is done
+ * and a change made after the scan must still wait for .commitConfig().
+ * A sweep must take no longer than the RX settle time plus the dwell time for each channel plus a little for SPI.
+ *
+ * Output is one line per case:
+ * case, busy channel occupancy (%), busiest other channel occupancy (%), sweep time (ms), time limit (ms), OK/FAIL
+ * followed by PASS or FAIL, the exit code is non-zero on FAIL
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_defs.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define BUSY_CHANNEL	20
+#define HOME_CHANNEL	300
+#define SLACK			50 // us per channel allowed for SPI and CE pulses on top of RX settle time + dwell time
+
+static nRF905SimAir air(1);
+static nRF905SimNode scannerNode(air);
+static nRF905SimNode interfererNode(air);
+static nRF905SimRadio scannerRadio(scannerNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio interfererRadio(interfererNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 scanner;
+static nRF905 interferer;
+
+static uint8_t occupancy[512];
+
+static bool run(bool batched, uint16_t dwell)
+{
+	uint64_t start = air.time();
+	bool ok = true;
+
+	scannerNode.run([&]{
+		if(batched)
+		{
+			scanner.beginConfig();
+			scanner.setPayloadSize(16, 16);
+		}
+
+		scanner.scanChannels(0, 511, dwell, occupancy);
+
+		if(batched)
+		{
+			// Must have been sent by .scanChannels()
+			uint8_t regs[NRF905_REGISTER_COUNT];
+			scanner.getConfigRegisters(regs);
+			if(regs[NRF905_REG_RX_PAYLOAD_SIZE] != 16 || regs[NRF905_REG_TX_PAYLOAD_SIZE] != 16)
+				ok = false;
+
+			// Still batching after the scan
+			scannerRadio.resetCounters();
+			scanner.setPayloadSize(32, 32);
+			if(scannerRadio.spiTransactions)
+				ok = false;
+			scanner.commitConfig();
+			if(scannerRadio.spiTransactions != 1)
+				ok = false;
+		}
+	});
+
+	double time = ((air.time() - start) / 1000) / 1000.0;
+	double limit = (512 * (NRF905_SIM_SETTLE_TIME + dwell + SLACK)) / 1000.0;
+
+	uint8_t busiestOther = 0;
+	for(uint16_t i=0;i<512;i++)
+	{
+		if(i != BUSY_CHANNEL && occupancy[i] > busiestOther)
+			busiestOther = occupancy[i];
+	}
+
+	// Back on its own channel
+	uint8_t regs[NRF905_REGISTER_COUNT];
+	scannerNode.run([&]{ scanner.getConfigRegisters(regs); });
+	if((regs[NRF905_REG_CHANNEL] | ((regs[NRF905_REG_CONFIG1] & 0x01)<<8)) != HOME_CHANNEL)
+		ok = false;
+
+	ok = ok && occupancy[BUSY_CHANNEL] >= 90 && busiestOther == 0 && time <= limit;
+
+	printf("%s,%u,%u,%.1f,%.1f,%s\n",
+		batched ? "batched" : "plain",
+		occupancy[BUSY_CHANNEL],
+		busiestOther,
+		time,
+		limit,
+		ok ? "OK" : "FAIL"
+	);
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	static uint16_t dwell;
+	dwell = (argc > 1) ? strtoul(argv[1], NULL, 10) : 250;
+
+	interfererNode.run([]{
+		SPI.begin();
+		interferer.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		interferer.setChannel(BUSY_CHANNEL);
+		interferer.setAutoRetransmit(true);
+		uint8_t buffer[NRF905_MAX_PAYLOAD];
+		memset(buffer, 0xAA, sizeof(buffer));
+		interferer.write(0xB54CAB34, buffer, sizeof(buffer));
+		interferer.TX(NRF905_NEXTMODE_TX, false);
+	});
+
+	// CD pin connected, DR and AM aren't needed
+	scannerNode.run([]{
+		SPI.begin();
+		scanner.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		scanner.setChannel(HOME_CHANNEL);
+		scanner.standby();
+	});
+
+	air.advance(10000000);
+
+	printf("case,busy_occupancy,other_occupancy,sweep_ms,limit_ms,result\n");
+	bool pass = run(false, dwell);
+	pass = run(true, dwell) && pass;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
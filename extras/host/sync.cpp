@@ -0,0 +1,230 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator time sync example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * A master sending nRF905Sync beacons and a group of nodes with drifting clocks keeping track of the master's time, with different error bounds
+ *
+ * g++ -O2 -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/sync.cpp src/nRF905*.cpp -o sync
+ * ./sync [nodes] [interval_ms] [seconds] [drift_ppm] [seed]
+ *
+ * Each node's clock is off by a random amount up to +/-drift_ppm. The nodes sleep in power-down mode between beacons.
+ * Every 10ms each node's idea of the master's time is compared with the master's real time.
+ * An error bound of 0 means every beacon is listened for.
+ *
+ * Output is CSV, one line per error bound:
+ * error bound (us), average error (us), worst error (us), samples within the bound (%), average radio on-time per node (%), highest radio on-time (%),
+ * average error of the nodes' drift estimates (ppm)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <map>
+#include <nRF905.h>
+#include <nRF905_sync.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define MAX_NODES		32
+#define SYNC_ADDR		0x3C8E51A7
+#define STEP			100000 // ns
+#define SAMPLE			10000000ULL // ns
+#define WARMUP			30000000000ULL // ns
+
+// The simulator runs the MCUs one after the other, so nodes reading the same beacon over SPI would hold up each other's timestamps.
+// An unrealistically fast SPI clock keeps that from skewing the results.
+#define SPI_CLOCK		4000000000UL
+
+typedef struct
+{
+	nRF905SimNode* mcu;
+	nRF905* radio;
+	nRF905Sync* sync;
+	int32_t drift;
+	uint64_t wakeAt;
+	uint32_t onTimeStart; // us
+} node_t;
+
+static nRF905SimAir air(1);
+static node_t nodes[MAX_NODES];
+static std::map<nRF905SimNode*, node_t*> mcuNodes;
+static nRF905SimNode* masterMcu;
+static nRF905 master;
+static nRF905Sync masterSync;
+
+static void master_int_dr(){master.interrupt_dr();}
+static void master_int_am(){master.interrupt_am();}
+
+// All nodes share the same interrupt functions, the simulator says which MCU is running
+static void node_int_dr(){mcuNodes[nRF905SimNode::current()]->radio->interrupt_dr();}
+static void node_int_am(){mcuNodes[nRF905SimNode::current()]->radio->interrupt_am();}
+static void node_onRxComplete(nRF905* device)
+{
+	(void)device;
+	mcuNodes[nRF905SimNode::current()]->sync->receive();
+}
+
+static void run(uint16_t count, uint16_t bound, uint16_t interval, uint32_t seconds, int32_t maxDrift, uint32_t seed)
+{
+	air.setSeed(seed);
+
+	masterMcu->run([&]{
+		SPI.begin();
+		master.begin(SPI, SPI_CLOCK, 6, 7, 9, 8, 4, 3, 2, master_int_dr, master_int_am);
+		master.setPayloadSize(NRF905_SYNC_BEACON_SIZE, NRF905_SYNC_BEACON_SIZE);
+		masterSync.beginMaster(master, SYNC_ADDR, interval);
+	});
+
+	for(uint16_t i=0;i<count;i++)
+	{
+		node_t* node = &nodes[i];
+		node->drift = maxDrift ? (int32_t)(air.random() % (maxDrift * 2 + 1)) - maxDrift : 0;
+		node->mcu->setClockDrift(node->drift);
+		node->mcu->run([&]{
+			SPI.begin();
+			node->radio->begin(SPI, SPI_CLOCK, 6, 7, 9, 8, 4, 3, 2, node_int_dr, node_int_am);
+			node->radio->events(node_onRxComplete, NULL, NULL, NULL);
+			node->radio->setPayloadSize(NRF905_SYNC_BEACON_SIZE, NRF905_SYNC_BEACON_SIZE);
+			node->sync->beginNode(*node->radio, SYNC_ADDR, bound, true);
+		});
+		node->wakeAt = 0;
+	}
+
+	uint64_t start = air.time();
+	uint64_t measureStart = start + WARMUP;
+	uint64_t end = measureStart + (seconds * 1000000000ULL);
+	uint64_t nextSample = measureStart;
+	bool measuring = false;
+
+	double errorTotal = 0;
+	double errorMax = 0;
+	uint32_t samples = 0;
+	uint32_t withinBound = 0;
+
+	while(air.time() < end)
+	{
+		if(!measuring && air.time() >= measureStart)
+		{
+			// Don't count the time spent getting in sync
+			measuring = true;
+			for(uint16_t i=0;i<count;i++)
+			{
+				node_t* node = &nodes[i];
+				node->mcu->run([&]{ node->onTimeStart = node->sync->onTime(); });
+			}
+		}
+
+		masterMcu->run([&]{ masterSync.service(); });
+
+		for(uint16_t i=0;i<count;i++)
+		{
+			node_t* node = &nodes[i];
+			if(air.time() < node->wakeAt)
+				continue;
+
+			node->mcu->run([&]{
+				node->sync->service();
+				node->wakeAt = air.time() + node->mcu->toAirTime(node->sync->sleepTime() * 1000ULL);
+			});
+		}
+
+		if(measuring && air.time() >= nextSample)
+		{
+			nextSample += SAMPLE;
+
+			unsigned long masterTime = 0;
+			masterMcu->run([&]{ masterTime = masterSync.time(); });
+
+			for(uint16_t i=0;i<count;i++)
+			{
+				node_t* node = &nodes[i];
+				bool synced = false;
+				unsigned long nodeTime = 0;
+				node->mcu->run([&]{
+					synced = node->sync->synced();
+					nodeTime = node->sync->time();
+				});
+
+				// Out of sync counts as outside the bound
+				double error = synced ? fabs((double)(long)(nodeTime - masterTime)) : INFINITY;
+				if(synced)
+				{
+					errorTotal += error;
+					if(error > errorMax)
+						errorMax = error;
+				}
+				if(error <= bound || (!bound && synced))
+					withinBound++;
+				samples++;
+			}
+		}
+
+		if(air.time() + STEP > nextSample && measuring)
+			air.advance(nextSample - air.time());
+		else
+			air.advance(STEP);
+	}
+
+	double onTotal = 0;
+	double onMax = 0;
+	double driftError = 0;
+	for(uint16_t i=0;i<count;i++)
+	{
+		node_t* node = &nodes[i];
+		node->mcu->run([&]{
+			double on = ((node->sync->onTime() - node->onTimeStart) * 1000.0 * 100.0) / (end - measureStart);
+			onTotal += on;
+			if(on > onMax)
+				onMax = on;
+			driftError += fabs(node->sync->drift() - node->drift);
+		});
+	}
+
+	printf("%u,%.1f,%.1f,%.2f,%.3f,%.3f,%.2f\n",
+		bound,
+		errorTotal / samples,
+		errorMax,
+		(withinBound * 100.0) / samples,
+		onTotal / count,
+		onMax,
+		driftError / count
+	);
+}
+
+int main(int argc, char** argv)
+{
+	uint16_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 8;
+	uint16_t interval = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000;
+	uint32_t seconds = (argc > 3) ? strtoul(argv[3], NULL, 10) : 300;
+	int32_t drift = (argc > 4) ? strtol(argv[4], NULL, 10) : 100;
+	uint32_t seed = (argc > 5) ? strtoul(argv[5], NULL, 10) : 1;
+
+	if(count > MAX_NODES)
+		count = MAX_NODES;
+
+	// Keep the time spent reading the clock from adding to the measured errors
+	air.setCpuTime(20);
+
+	masterMcu = new nRF905SimNode(air);
+	new nRF905SimRadio(*masterMcu, 6, 7, 9, 8, 4, 3, 2);
+	for(uint16_t i=0;i<count;i++)
+	{
+		nodes[i].mcu = new nRF905SimNode(air);
+		new nRF905SimRadio(*nodes[i].mcu, 6, 7, 9, 8, 4, 3, 2);
+		nodes[i].radio = new nRF905();
+		nodes[i].sync = new nRF905Sync();
+		mcuNodes[nodes[i].mcu] = &nodes[i];
+	}
+
+	printf("error_bound_us,error_avg_us,error_max_us,within_bound_pct,on_time_pct,on_time_max_pct,drift_error_ppm\n");
+	uint16_t bounds[] = {0, 50, 100, 250, 500, 1000, 5000};
+	for(uint8_t b=0;b<sizeof(bounds)/sizeof(bounds[0]);b++)
+		run(count, bounds[b], interval, seconds, drift, seed);
+
+	return 0;
+}
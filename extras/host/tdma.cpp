@@ -0,0 +1,279 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator TDMA example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * A large fleet of sensor nodes sending readings to one base station, waking up and sending blindly (like the lowpwr_node_sensor example)
+ * compared to nRF905Tdma time slots
+ *
+ * g++ -O2 -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/tdma.cpp src/nRF905*.cpp -o tdma
+ * ./tdma [interval_s] [seconds] [drift_ppm] [seed]
+ *
+ * Each node sends an 8 byte reading every interval_s seconds, starting at a random time. Each node's clock is off by a random amount up to +/-drift_ppm.
+ * The nodes sleep in power-down mode between readings.
+ *
+ * Output is CSV, one line per fleet size and mode:
+ * nodes, mode, readings sent, readings delivered, delivery (%), collisions on air, collisions per reading (%), average radio on-time per node (%), highest radio on-time (%),
+ * average error of the nodes' drift estimates (ppm)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <map>
+#include <nRF905.h>
+#include <nRF905_tdma.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define MAX_NODES		400
+#define BASE_ADDR		0xA94EC554
+#define BEACON_ADDR		0x7A5C1E90
+#define READING_SIZE	8
+#define GUARD			250 // us
+#define RESYNC			32 // Frames
+#define STEP			100000 // ns
+#define WARMUP			15000000000ULL // ns
+
+// The simulator runs the MCUs one after the other, so hundreds of nodes reading the same beacon over SPI would hold each other up.
+// An unrealistically fast SPI clock keeps that from skewing the results.
+#define SPI_CLOCK		4000000000UL
+
+typedef struct
+{
+	nRF905SimNode* mcu;
+	nRF905* radio;
+	nRF905Tdma* tdma;
+	int32_t drift;
+	uint32_t seq;
+	uint64_t nextAt;
+	uint64_t wakeAt;
+	bool sending;
+	uint64_t onSince;
+	uint64_t onTime; // ns
+	uint32_t onTimeStart; // us
+} node_t;
+
+static nRF905SimAir air(1);
+static node_t nodes[MAX_NODES];
+static std::map<nRF905SimNode*, node_t*> mcuNodes;
+static nRF905SimNode* baseMcu;
+static nRF905 base;
+static nRF905Tdma baseTdma;
+
+static uint32_t delivered;
+
+static void base_int_dr(){base.interrupt_dr();}
+static void base_int_am(){base.interrupt_am();}
+static void base_onRxComplete(nRF905* device)
+{
+	uint8_t reading[READING_SIZE];
+	device->read(reading, sizeof(reading));
+	delivered++;
+}
+
+// All nodes share the same interrupt functions, the simulator says which MCU is running
+static void node_int_dr(){mcuNodes[nRF905SimNode::current()]->radio->interrupt_dr();}
+static void node_int_am(){mcuNodes[nRF905SimNode::current()]->radio->interrupt_am();}
+static void node_onRxComplete(nRF905* device)
+{
+	(void)device;
+	mcuNodes[nRF905SimNode::current()]->tdma->receive();
+}
+
+static void run(uint16_t count, bool tdma, uint32_t interval, uint32_t seconds, int32_t maxDrift, uint32_t seed)
+{
+	air.setSeed(seed);
+	delivered = 0;
+
+	baseMcu->run([&]{
+		SPI.begin();
+		base.begin(SPI, SPI_CLOCK, 6, 7, 9, 8, 4, 3, 2, base_int_dr, base_int_am);
+		base.events(base_onRxComplete, NULL, NULL, NULL);
+		base.setListenAddress(BASE_ADDR);
+		base.setPayloadSize(NRF905_MAX_PAYLOAD, READING_SIZE);
+		if(tdma)
+			baseTdma.beginBase(base, BEACON_ADDR, count, GUARD);
+		else
+			base.RX();
+	});
+
+	uint64_t start = air.time();
+	for(uint16_t i=0;i<count;i++)
+	{
+		node_t* node = &nodes[i];
+		node->drift = maxDrift ? (int32_t)(air.random() % (maxDrift * 2 + 1)) - maxDrift : 0;
+		node->mcu->setClockDrift(node->drift);
+		node->mcu->run([&]{
+			SPI.begin();
+			node->radio->begin(SPI, SPI_CLOCK, 6, 7, 9, 8, 4, 3, 2, node_int_dr, node_int_am);
+			node->radio->events(node_onRxComplete, NULL, NULL, NULL);
+			node->radio->setPayloadSize(READING_SIZE, NRF905_MAX_PAYLOAD);
+			if(tdma)
+				node->tdma->beginNode(*node->radio, BEACON_ADDR, i, true, RESYNC);
+			else
+				node->radio->powerDown();
+		});
+		node->seq = 0;
+		node->sending = false;
+		node->onTime = 0;
+		node->wakeAt = 0;
+		node->nextAt = start + WARMUP + ((air.random() % (interval * 1000)) * 1000000ULL);
+	}
+
+	uint32_t collisions = 0;
+	uint32_t sent = 0;
+	uint64_t measureStart = start + WARMUP;
+	uint64_t measureEnd = measureStart + (seconds * 1000000000ULL);
+	uint64_t end = measureEnd + (interval * 1000000000ULL); // Let the last readings get sent
+	bool measuring = false;
+
+	while(air.time() < end)
+	{
+		if(!measuring && air.time() >= measureStart)
+		{
+			// Don't count the time spent getting in sync
+			measuring = true;
+			collisions = air.collisions;
+			for(uint16_t i=0;i<count;i++)
+			{
+				node_t* node = &nodes[i];
+				node->onTime = 0;
+				if(tdma)
+					node->mcu->run([&]{ node->onTimeStart = node->tdma->onTime(); });
+			}
+		}
+
+		if(tdma)
+			baseMcu->run([&]{ baseTdma.service(); });
+
+		for(uint16_t i=0;i<count;i++)
+		{
+			node_t* node = &nodes[i];
+			if(air.time() < node->wakeAt)
+				continue;
+
+			node->mcu->run([&]{
+				bool newReading = false;
+				if(air.time() >= node->nextAt)
+				{
+					node->nextAt += interval * 1000000000ULL;
+					newReading = (air.time() < measureEnd);
+				}
+
+				uint8_t reading[READING_SIZE];
+				memset(reading, 0, sizeof(reading));
+				memcpy(reading, &i, sizeof(i));
+				memcpy(&reading[2], &node->seq, sizeof(node->seq));
+
+				if(tdma)
+				{
+					if(newReading && node->tdma->send(BASE_ADDR, reading, sizeof(reading)))
+					{
+						node->seq++;
+						sent++;
+					}
+
+					node->tdma->service();
+					node->wakeAt = air.time() + node->mcu->toAirTime(node->tdma->sleepTime() * 1000ULL);
+				}
+				else
+				{
+					if(newReading && !node->sending)
+					{
+						// Power up, send and power down as soon as it's been sent
+						node->radio->write(BASE_ADDR, reading, sizeof(reading));
+						node->radio->startTX(NRF905_NEXTMODE_STANDBY, false);
+						node->sending = true;
+						node->onSince = air.time();
+						node->seq++;
+						sent++;
+					}
+
+					if(node->sending && node->radio->service() && !node->radio->transmitting())
+					{
+						node->radio->powerDown();
+						node->sending = false;
+						node->onTime += air.time() - node->onSince;
+					}
+
+					node->wakeAt = node->sending ? 0 : node->nextAt;
+				}
+
+				if(node->wakeAt > node->nextAt)
+					node->wakeAt = node->nextAt;
+			});
+		}
+
+		air.advance(STEP);
+	}
+
+	double onTotal = 0;
+	double onMax = 0;
+	double driftError = 0;
+	for(uint16_t i=0;i<count;i++)
+	{
+		node_t* node = &nodes[i];
+		if(tdma)
+		{
+			node->mcu->run([&]{
+				node->onTime = (node->tdma->onTime() - node->onTimeStart) * 1000ULL;
+				driftError += fabs(node->tdma->drift() - node->drift);
+			});
+		}
+
+		double on = (node->onTime * 100.0) / (end - measureStart);
+		onTotal += on;
+		if(on > onMax)
+			onMax = on;
+	}
+
+	printf("%u,%s,%u,%u,%.1f,%u,%.2f,%.3f,%.3f,%.1f\n",
+		count,
+		tdma ? "tdma" : "blind",
+		sent,
+		delivered,
+		sent ? (delivered * 100.0) / sent : 0,
+		air.collisions - collisions,
+		sent ? ((air.collisions - collisions) * 100.0) / sent : 0,
+		onTotal / count,
+		onMax,
+		tdma ? driftError / count : 0
+	);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t interval = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10;
+	uint32_t seconds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 60;
+	int32_t drift = (argc > 3) ? strtol(argv[3], NULL, 10) : 100;
+	uint32_t seed = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1;
+
+	// Hundreds of nodes reading the clock would otherwise use up lots of simulated time
+	air.setCpuTime(20);
+
+	baseMcu = new nRF905SimNode(air);
+	new nRF905SimRadio(*baseMcu, 6, 7, 9, 8, 4, 3, 2);
+	for(uint16_t i=0;i<MAX_NODES;i++)
+	{
+		nodes[i].mcu = new nRF905SimNode(air);
+		new nRF905SimRadio(*nodes[i].mcu, 6, 7, 9, 8, 4, 3, 2);
+		nodes[i].radio = new nRF905();
+		nodes[i].tdma = new nRF905Tdma();
+		mcuNodes[nodes[i].mcu] = &nodes[i];
+	}
+
+	printf("nodes,mode,sent,delivered,delivery_pct,collisions,collisions_pct,on_time_pct,on_time_max_pct,drift_error_ppm\n");
+	uint16_t counts[] = {50, 100, 200, 400};
+	for(uint8_t c=0;c<sizeof(counts)/sizeof(counts[0]);c++)
+	{
+		run(counts[c], false, interval, seconds, drift, seed);
+		run(counts[c], true, interval, seconds, drift, seed);
+	}
+
+	return 0;
+}
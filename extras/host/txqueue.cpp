@@ -0,0 +1,209 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator transmit queue example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Fill the transmit queue, let it drain back-to-back and check the payloads go out in order
+ *
+ * NRF905_TX_QUEUE_SLOTS must be set in nRF905_config.h, for example build against a copy of src with it changed:
+ * cp -r src /tmp/txq && sed -i 's/#define NRF905_TX_QUEUE_SLOTS.*0$/#define NRF905_TX_QUEUE_SLOTS\t8/' /tmp/txq/nRF905_config.h
+ * g++ -O2 -std=c++11 -Iextras/host -I/tmp/txq extras/host/nRF905_sim.cpp extras/host/txqueue.cpp /tmp/txq/nRF905*.cpp -o txqueue
+ * ./txqueue [rounds] [seed]
+ *
+ * Each round fills the queue with .enqueue() and then only calls .service() until .txQueueLength() is 0.
+ * Enough rounds are run for the 8 bit IDs to wrap around a few times.
+ * After each payload finishes (onTxComplete) the ID of that payload must be sent according to .txQueueSent() and the next one must not be.
+ * The receiver must get every payload in order, and the gap between one payload finishing and the next one finishing must be no more than
+ * one payload's TX settle time plus airtime plus a little for .service() to notice.
+ *
+ * Output is one line per mode:
+ * mode, payloads queued, payloads received, received out of order, IDs seen out of order, largest gap between payloads (us), time per payload (us)
+ * followed by PASS or FAIL, the exit code is non-zero on FAIL
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define RECEIVER_ADDR	0xA94EC554
+#define PAYLOAD_SIZE	32
+#define SLACK			200 // us allowed on top of TX settle time + airtime for .service() to start the next payload
+
+static nRF905SimAir air(1);
+static nRF905SimNode senderNode(air);
+static nRF905SimNode receiverNode(air);
+static nRF905SimRadio senderRadio(senderNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio receiverRadio(receiverNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 sender;
+static nRF905 receiver;
+
+#if NRF905_TX_QUEUE_SLOTS
+
+static uint8_t ids[NRF905_TX_QUEUE_SLOTS];
+static uint8_t idCount;
+static uint8_t idDone;
+static uint32_t idErrors;
+static uint32_t lastComplete;
+static uint32_t maxGap;
+
+static uint32_t received;
+static uint32_t outOfOrder;
+
+static void sender_int_dr(){sender.interrupt_dr();}
+static void sender_int_am(){sender.interrupt_am();}
+static void receiver_int_dr(){receiver.interrupt_dr();}
+static void receiver_int_am(){receiver.interrupt_am();}
+
+static void sender_onTxComplete(nRF905* device)
+{
+	// The oldest ID still waiting must be sent now and the one after it must not be
+	if(idDone >= idCount || !device->txQueueSent(ids[idDone]))
+		idErrors++;
+	else if(idDone + 1 < idCount && device->txQueueSent(ids[idDone + 1]))
+		idErrors++;
+	idDone++;
+
+	uint32_t now = micros();
+	if(lastComplete && idDone > 1 && now - lastComplete > maxGap)
+		maxGap = now - lastComplete;
+	lastComplete = now;
+}
+
+static void receiver_onRxComplete(nRF905* device)
+{
+	uint8_t buffer[PAYLOAD_SIZE];
+	device->read(buffer, sizeof(buffer));
+	uint32_t count;
+	memcpy(&count, buffer, sizeof(count));
+	if(count != received)
+		outOfOrder++;
+	received++;
+}
+
+static bool run(bool polled, uint32_t rounds)
+{
+	senderNode.run([&]{
+		SPI.begin();
+		if(polled)
+		{
+			// The interrupt run left its handlers attached
+			detachInterrupt(digitalPinToInterrupt(3));
+			detachInterrupt(digitalPinToInterrupt(2));
+			sender.begin(SPI, 10000000, 6, 7, 9, 8, 4, NRF905_PIN_UNUSED, NRF905_PIN_UNUSED, NULL, NULL);
+		}
+		else
+			sender.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, sender_int_dr, sender_int_am);
+		sender.events(NULL, NULL, sender_onTxComplete, NULL);
+		sender.setPayloadSize(PAYLOAD_SIZE, PAYLOAD_SIZE);
+		sender.standby();
+	});
+
+	receiverNode.run([&]{
+		SPI.begin();
+		receiver.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, receiver_int_dr, receiver_int_am);
+		receiver.setListenAddress(RECEIVER_ADDR);
+		receiver.setPayloadSize(PAYLOAD_SIZE, PAYLOAD_SIZE);
+		receiver.events(receiver_onRxComplete, NULL, NULL, NULL);
+		receiver.RX();
+	});
+
+	air.advance(10000000);
+
+	uint32_t queued = 0;
+	uint32_t sendTime = 0;
+	idErrors = 0;
+	maxGap = 0;
+	received = 0;
+	outOfOrder = 0;
+
+	for(uint32_t r=0;r<rounds;r++)
+	{
+		idCount = 0;
+		idDone = 0;
+		lastComplete = 0;
+
+		uint64_t start = air.time();
+
+		senderNode.run([&]{
+			uint8_t buffer[PAYLOAD_SIZE];
+			memset(buffer, 0, sizeof(buffer));
+			while(1)
+			{
+				memcpy(buffer, &queued, sizeof(queued));
+				int16_t id = sender.enqueue(RECEIVER_ADDR, buffer, sizeof(buffer));
+				if(id < 0)
+					break;
+				ids[idCount++] = id;
+				queued++;
+			}
+		});
+
+		// Give up if the queue hasn't drained after twice as long as it should take
+		uint64_t timeout = start + ((uint64_t)idCount * 2 * (NRF905_SIM_SETTLE_TIME + NRF905_CALC_AIRTIME(4, PAYLOAD_SIZE, 2) + SLACK) * 1000);
+		bool busy = true;
+		while(busy && air.time() < timeout)
+		{
+			senderNode.run([&]{
+				if(polled)
+					sender.poll();
+				sender.service();
+				busy = sender.txQueueLength();
+			});
+			air.advance(10000); // 10us
+		}
+
+		sendTime += (air.time() - start) / 1000;
+
+		// Let the last payload arrive
+		air.advance(1000000);
+
+		if(idDone != idCount)
+			idErrors++;
+	}
+
+	printf("%s,%u,%u,%u,%u,%u,%.1f\n",
+		polled ? "polled" : "interrupt",
+		queued,
+		received,
+		outOfOrder,
+		idErrors,
+		maxGap,
+		sendTime / (double)queued
+	);
+
+	uint32_t limit = NRF905_SIM_SETTLE_TIME + NRF905_CALC_AIRTIME(4, PAYLOAD_SIZE, 2) + SLACK;
+	return (received == queued && !outOfOrder && !idErrors && maxGap <= limit);
+}
+
+int main(int argc, char** argv)
+{
+	// Enough rounds for the IDs to wrap around a few times
+	uint32_t rounds = (argc > 1) ? strtoul(argv[1], NULL, 10) : (1024 / NRF905_TX_QUEUE_SLOTS);
+	uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+
+	air.setSeed(seed);
+
+	printf("mode,queued,received,out_of_order,id_errors,max_gap_us,us_per_payload\n");
+	bool pass = run(false, rounds);
+	pass = run(true, rounds) && pass;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
+
+#else
+
+int main()
+{
+	printf("NRF905_TX_QUEUE_SLOTS is 0, set it in nRF905_config.h to run this\n");
+	return 1;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Project: nRF905 Radio Library for Arduino (Host simulator wake-on-radio example)
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+/*
+ * Send payloads to a receiver that's using nRF905Wor low power listening with different periods
+ *
+ * g++ -std=c++11 -Iextras/host -Isrc extras/host/nRF905_sim.cpp extras/host/wor.cpp src/nRF905*.cpp -o wor
+ * ./wor [payloads] [interval_ms] [window_us]
+ *
+ * Output is CSV, one line per period:
+ * period (ms), payloads sent, payloads received, average latency from sending to receiving (ms), receiver average current (uA), sender average current (uA)
+ *
+ * A receiver that stays in receive mode all the time uses 12500uA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nRF905.h>
+#include <nRF905_wor.h>
+#include <SPI.h>
+#include "nRF905_sim.h"
+
+#define SENDER_ADDR		0xB54CAB34
+#define RECEIVER_ADDR	0xA94EC554
+
+static nRF905SimAir air(1);
+static nRF905SimNode senderNode(air);
+static nRF905SimNode receiverNode(air);
+static nRF905SimRadio senderRadio(senderNode, 6, 7, 9, 8, 4, 3, 2);
+static nRF905SimRadio receiverRadio(receiverNode, 6, 7, 9, 8, 4, 3, 2);
+
+static nRF905 sender;
+static nRF905 receiver;
+static nRF905Wor senderWor;
+static nRF905Wor receiverWor;
+
+static uint32_t received;
+static uint64_t totalLatency;
+
+static void sender_int_dr(){sender.interrupt_dr();}
+static void sender_int_am(){sender.interrupt_am();}
+static void receiver_int_dr(){receiver.interrupt_dr();}
+static void receiver_int_am(){receiver.interrupt_am();}
+static void receiver_onRxComplete(nRF905* device)
+{
+	uint8_t payload[NRF905_MAX_PAYLOAD];
+	device->read(payload, sizeof(payload));
+
+	uint64_t sentAt;
+	memcpy(&sentAt, payload, sizeof(sentAt));
+	totalLatency += air.time() - sentAt;
+	received++;
+}
+
+static void run(uint16_t period, uint32_t payloads, uint32_t interval, uint16_t window)
+{
+	received = 0;
+	totalLatency = 0;
+
+	senderNode.run([&]{
+		SPI.begin();
+		sender.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, sender_int_dr, sender_int_am);
+		sender.setListenAddress(SENDER_ADDR);
+		senderWor.begin(sender, period, window, true);
+	});
+
+	receiverNode.run([&]{
+		SPI.begin();
+		receiver.begin(SPI, 10000000, 6, 7, 9, 8, 4, 3, 2, receiver_int_dr, receiver_int_am);
+		receiver.events(receiver_onRxComplete, NULL, NULL, NULL);
+		receiver.setListenAddress(RECEIVER_ADDR);
+		receiverWor.begin(receiver, period, window, true);
+	});
+
+	uint32_t sent = 0;
+	uint64_t nextSend = air.time() + (air.random() % (interval * 1000000ULL));
+	uint64_t end = air.time() + (payloads * interval * 1000000ULL);
+
+	while(air.time() < end)
+	{
+		senderNode.run([&]{
+			if(air.time() >= nextSend && !senderWor.sending())
+			{
+				uint8_t payload[NRF905_MAX_PAYLOAD];
+				uint64_t now = air.time();
+				memcpy(payload, &now, sizeof(now));
+				if(senderWor.send(RECEIVER_ADDR, payload, sizeof(payload)))
+				{
+					sent++;
+					nextSend += interval * 1000000ULL;
+				}
+			}
+			senderWor.service();
+		});
+
+		receiverNode.run([&]{
+			receiverWor.service();
+		});
+
+		air.advance(50000); // 50us
+	}
+
+	float senderCurrent;
+	float receiverCurrent;
+	senderNode.run([&]{ senderCurrent = senderWor.averageCurrent(); });
+	receiverNode.run([&]{ receiverCurrent = receiverWor.averageCurrent(); });
+
+	printf("%u,%u,%u,%.1f,%.1f,%.1f\n",
+		period,
+		sent,
+		received,
+		received ? (totalLatency / (double)received) / 1000000.0 : 0,
+		receiverCurrent,
+		senderCurrent
+	);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t payloads = (argc > 1) ? strtoul(argv[1], NULL, 10) : 20;
+	uint32_t interval = (argc > 2) ? strtoul(argv[2], NULL, 10) : 3000;
+	uint16_t window = (argc > 3) ? atoi(argv[3]) : 500;
+
+	printf("period_ms,sent,received,latency_ms,receiver_uA,sender_uA\n");
+	uint16_t periods[] = {50, 100, 250, 500, 1000};
+	for(uint8_t i=0;i<sizeof(periods)/sizeof(periods[0]);i++)
+		run(periods[i], payloads, interval, window);
+
+	return 0;
+}
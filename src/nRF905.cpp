@@ -28,6 +28,63 @@ static const uint8_t config[] PROGMEM = {
 	NRF905_CRC | NRF905_CLK_FREQ | NRF905_OUTCLK
 };
 
+#if NRF905_FAST_GPIO && !defined(__AVR__)
+	#error "NRF905_FAST_GPIO is only supported on AVR"
+#endif
+
+#if NRF905_FAST_GPIO
+// Direct port access, digitalWrite() and digitalRead() take a few microseconds on AVR since they look up the port and bit mask and check for PWM on every call
+// The pins are only known at run time so the port is reached through a pointer, which means each write is a read-modify-write (LD, OR/AND, ST) instead of a single SBI/CBI
+// Unused pins are never passed to PIN_WRITE()/PIN_READ(), the callers already check for NRF905_PIN_UNUSED the same as with digitalWrite()
+static void fastPinInit(nRF905_fastpin_t* fastPin, uint8_t pin, bool output)
+{
+	if(pin == NRF905_PIN_UNUSED)
+		return;
+
+	uint8_t port = digitalPinToPort(pin);
+	fastPin->reg = output ? portOutputRegister(port) : portInputRegister(port);
+	fastPin->mask = digitalPinToBitMask(pin);
+}
+
+static inline void fastPinWrite(const nRF905_fastpin_t& fastPin, uint8_t val)
+{
+	// Interrupts are disabled for the read-modify-write so an ISR that writes to another pin on the same port doesn't get its change undone,
+	// SREG is saved and restored so this is also safe to call from inside the DR and AM interrupts
+	uint8_t sreg = SREG;
+	cli();
+	if(val)
+		*fastPin.reg |= fastPin.mask;
+	else
+		*fastPin.reg &= ~fastPin.mask;
+	SREG = sreg;
+}
+
+static inline uint8_t fastPinRead(const nRF905_fastpin_t& fastPin)
+{
+	// Reading the output register of an output pin gives the level it was set to, same as digitalRead()
+	return (*fastPin.reg & fastPin.mask) ? HIGH : LOW;
+}
+
+	#define PIN_WRITE(pin, val)	fastPinWrite(pin##Fast, val)
+	#define PIN_READ(pin)		fastPinRead(pin##Fast)
+#else
+	#define PIN_WRITE(pin, val)	digitalWrite(pin, val)
+	#define PIN_READ(pin)		digitalRead(pin)
+#endif
+
+#if NRF905_STATS
+	#define STATS_INC(field)		(stats.field++)
+	#define STATS_ADD(field, val)	(stats.field += (val))
+#else
+	#define STATS_INC(field)		((void)0)
+	#define STATS_ADD(field, val)	((void)0)
+#endif
+
+// Stages of a transmission started by startTX(), see service()
+#define TXSTAGE_IDLE		0
+#define TXSTAGE_POWERUP		1 // Waiting for the radio to power-up before starting the transmission
+#define TXSTAGE_NEXTMODE	2 // Transmission has started, waiting to enter the next mode
+
 inline uint8_t nRF905::cselect()
 {
 #if defined(ESP32) || defined(ESP8266)
@@ -35,13 +92,14 @@ inline uint8_t nRF905::cselect()
 		noInterrupts();
 #endif
 	spi.beginTransaction(spiSettings);
-	digitalWrite(csn, LOW);
+	PIN_WRITE(csn, LOW);
+	STATS_INC(spiTransactions);
 	return 1;
 }
 
 inline uint8_t nRF905::cdeselect()
 {
-	digitalWrite(csn, HIGH);
+	PIN_WRITE(csn, HIGH);
 	spi.endTransaction();
 #if defined(ESP32) || defined(ESP8266)
 	if(!isrBusy)
@@ -50,39 +108,93 @@ inline uint8_t nRF905::cdeselect()
 	return 0;
 }
 
+#if NRF905_RX_BUFFER_SLOTS & (NRF905_RX_BUFFER_SLOTS - 1)
+	#error "NRF905_RX_BUFFER_SLOTS must be a power of 2"
+#endif
+
+#if NRF905_TX_QUEUE_SLOTS & (NRF905_TX_QUEUE_SLOTS - 1)
+	#error "NRF905_TX_QUEUE_SLOTS must be a power of 2"
+#endif
+
 // Can be in any mode to write registers, but standby or power-down is recommended
 #define CHIPSELECT()	for(uint8_t _cs = cselect(); _cs; _cs = cdeselect())
 
-uint8_t nRF905::readConfigRegister(uint8_t reg)
+// Transfer a single byte (must be inside CHIPSELECT())
+inline uint8_t nRF905::spiTransfer(uint8_t data)
 {
-	uint8_t val = 0;
-	CHIPSELECT()
+	STATS_INC(spiBytes);
+	return spi.transfer(data);
+}
+
+// Send a block of bytes, anything received is thrown away (must be inside CHIPSELECT())
+void nRF905::spiWrite(const void* data, uint8_t len)
+{
+	STATS_ADD(spiBytes, len);
+#if NRF905_SPI_BLOCK_TRANSFER && (defined(ESP32) || defined(ESP8266))
+	spi.writeBytes((const uint8_t*)data, len);
+#elif NRF905_SPI_BLOCK_TRANSFER
+	// SPI.transfer(buf, len) overwrites the buffer with the received data, so a copy must be used
+	// Anything bigger than the copy goes out in chunks
+	uint8_t buff[NRF905_MAX_PAYLOAD];
+	const uint8_t* src = (const uint8_t*)data;
+	while(len)
 	{
-		spi.transfer(NRF905_CMD_R_CONFIG | reg);
-		val = spi.transfer(NRF905_CMD_NOP);
+		uint8_t chunk = (len > sizeof(buff)) ? sizeof(buff) : len;
+		memcpy(buff, src, chunk);
+		spi.transfer(buff, chunk);
+		src += chunk;
+		len -= chunk;
 	}
-	return val;
+#else
+	for(uint8_t i=0;i<len;i++)
+		spi.transfer(((uint8_t*)data)[i]);
+#endif
 }
 
-void nRF905::writeConfigRegister(uint8_t reg, uint8_t val)
+// Receive a block of bytes while sending NOPs (must be inside CHIPSELECT())
+void nRF905::spiRead(void* data, uint8_t len)
 {
+	STATS_ADD(spiBytes, len);
+#if NRF905_SPI_BLOCK_TRANSFER
+	memset(data, NRF905_CMD_NOP, len);
+	spi.transfer(data, len);
+#else
+	for(uint8_t i=0;i<len;i++)
+		((uint8_t*)data)[i] = spi.transfer(NRF905_CMD_NOP);
+#endif
+}
+
+// Write count registers starting from reg out of the shadow copy, or just mark them as dirty if between .beginConfig() and .commitConfig()
+void nRF905::writeConfig(uint8_t reg, uint8_t count)
+{
+	if(configBatch)
+	{
+		configDirty |= ((1<<count) - 1)<<reg;
+		return;
+	}
+
 	CHIPSELECT()
 	{
-		spi.transfer(NRF905_CMD_W_CONFIG | reg);
-		spi.transfer(val);
+		spiTransfer(NRF905_CMD_W_CONFIG | reg);
+		spiWrite(&configRegs[reg], count);
 	}
 }
 
+void nRF905::writeConfigRegister(uint8_t reg, uint8_t val)
+{
+	configRegs[reg] = val;
+	writeConfig(reg, 1);
+}
+
+// The shadow copy is used instead of reading the register back from the radio, so these are write-only
 void nRF905::setConfigReg1(uint8_t val, uint8_t mask, uint8_t reg)
 {
-	// TODO atomic read/write?
-	writeConfigRegister(reg, (readConfigRegister(NRF905_REG_CONFIG1) & mask) | val);
+	writeConfigRegister(reg, (configRegs[NRF905_REG_CONFIG1] & mask) | val);
 }
 
 void nRF905::setConfigReg2(uint8_t val, uint8_t mask, uint8_t reg)
 {
-	// TODO atomic read/write?
-	writeConfigRegister(reg, (readConfigRegister(NRF905_REG_CONFIG2) & mask) | val);
+	writeConfigRegister(reg, (configRegs[NRF905_REG_CONFIG2] & mask) | val);
 }
 
 void nRF905::defaultConfig()
@@ -93,25 +205,25 @@ void nRF905::defaultConfig()
 	CHIPSELECT()
 	{
 		for(uint8_t i=0;i<sizeof(config);i++)
-			spi.transfer(pgm_read_byte(&((uint8_t*)config)[i]));
+			spiTransfer(pgm_read_byte(&((uint8_t*)config)[i]));
 	}
 
+	// Seed shadow registers (skip the W_CONFIG command byte)
+	for(uint8_t i=0;i<NRF905_REGISTER_COUNT;i++)
+		configRegs[i] = pgm_read_byte(&((uint8_t*)config)[i + 1]);
+
 	// Default transmit address
 	// TODO is this really needed?
-	CHIPSELECT()
-	{
-		spi.transfer(NRF905_CMD_W_TX_ADDRESS);
-		for(uint8_t i=0;i<4;i++)
-			spi.transfer(0xE7);
-	}
+	txAddressValid = false;
+	setTxAddress(NRF905_DEFAULT_TXADDR);
 
 	// Clear transmit payload
 	// TODO is this really needed?
 	CHIPSELECT()
 	{
-		spi.transfer(NRF905_CMD_W_TX_PAYLOAD);
+		spiTransfer(NRF905_CMD_W_TX_PAYLOAD);
 		for(uint8_t i=0;i<NRF905_MAX_PAYLOAD;i++)
-			spi.transfer(0x00);
+			spiTransfer(0x00);
 	}
 
 	if(pwr == NRF905_PIN_UNUSED)
@@ -119,9 +231,9 @@ void nRF905::defaultConfig()
 		// Clear DR by reading receive payload
 		CHIPSELECT()
 		{
-			spi.transfer(NRF905_CMD_R_RX_PAYLOAD);
+			spiTransfer(NRF905_CMD_R_RX_PAYLOAD);
 			for(uint8_t i=0;i<NRF905_MAX_PAYLOAD;i++)
-				spi.transfer(NRF905_CMD_NOP);
+				spiTransfer(NRF905_CMD_NOP);
 		}
 	}
 }
@@ -130,31 +242,39 @@ void nRF905::defaultConfig()
 inline void nRF905::powerOn(bool val)
 {
 	if(pwr != NRF905_PIN_UNUSED)
-		digitalWrite(pwr, val ? HIGH : LOW);
+	{
+		// Remember when the radio was powered up so TX doesn't have to wait the full power-up time if some of it has already passed
+		if(val && !PIN_READ(pwr))
+		{
+			powerUpTime = micros();
+			powerUpWait = true;
+		}
+		PIN_WRITE(pwr, val ? HIGH : LOW);
+	}
 }
 
 inline void nRF905::standbyMode(bool val)
 {
 	if(trx != NRF905_PIN_UNUSED)
-		digitalWrite(trx, val ? LOW : HIGH);
+		PIN_WRITE(trx, val ? LOW : HIGH);
 }
 
 inline void nRF905::txMode(bool val)
 {
 	if(tx != NRF905_PIN_UNUSED)
-		digitalWrite(tx, val ? HIGH : LOW);
+		PIN_WRITE(tx, val ? HIGH : LOW);
 }
 
 void nRF905::setAddress(uint32_t address, uint8_t cmd)
 {
+	uint8_t buff[4];
+	for(uint8_t i=0;i<4;i++)
+		buff[i] = address>>(8 * i);
+
 	CHIPSELECT()
 	{
-		spi.transfer(cmd);
-		//spi.transfer16(address);
-		//spi.transfer16(address>>16);
-		for(uint8_t i=0;i<4;i++)
-			spi.transfer(address>>(8 * i));
-		//spi.transfer(&address, 4);
+		spiTransfer(cmd);
+		spiWrite(buff, sizeof(buff));
 	}
 }
 
@@ -162,7 +282,7 @@ uint8_t nRF905::readStatus()
 {
 	uint8_t status = 0;
 	CHIPSELECT()
-		status = spi.transfer(NRF905_CMD_NOP);
+		status = spiTransfer(NRF905_CMD_NOP);
 	return status;
 }
 
@@ -180,11 +300,43 @@ bool nRF905::addressMatched()
 {
 	if(am == NRF905_PIN_UNUSED)
 		return (readStatus() & (1<<NRF905_STATUS_AM));
-	return digitalRead(am);
+	return PIN_READ(am);
 }
 
 nRF905::nRF905()
 {
+	configBatch = false;
+	configDirty = 0;
+	txAddressValid = false;
+	txStage = TXSTAGE_IDLE;
+	txStaged = false;
+	txActive = false;
+	powerUpWait = false;
+	autoPayloadSize = false;
+	fixedPayloadSize = NRF905_PAYLOAD_SIZE_TX;
+	payloadClasses = NULL;
+	payloadClassCount = 0;
+	dutyPerMille = 0;
+	dutyCredit = 0;
+	dutyUpdated = 0;
+	rxTime = 0;
+	txTime = 0;
+	amTime = 0;
+#if NRF905_STATS
+	memset(&stats, 0, sizeof(nRF905_stats_t));
+#endif
+#if NRF905_RX_BUFFER_SLOTS
+	rxHead = 0;
+	rxTail = 0;
+	rxOverflows = 0;
+#endif
+#if NRF905_TX_QUEUE_SLOTS
+	txHead = 0;
+	txTail = 0;
+	txQueueBusy = false;
+	txQueueReady = false;
+	txQueueNextMode = NRF905_NEXTMODE_STANDBY;
+#endif
 }
 
 void nRF905::begin(
@@ -201,6 +353,9 @@ void nRF905::begin(
 	void (*callback_interrupt_am)()
 )
 {
+	// The radio might have only just got power, or begin() could be getting called again, so time any power-up wait from here
+	unsigned long start = micros();
+
 	this->spi = spi;
 	this->spiSettings = SPISettings(spiClock, MSBFIRST, SPI_MODE0);
 
@@ -212,6 +367,15 @@ void nRF905::begin(
 	this->dr = dr;
 	this->am = am;
 
+#if NRF905_FAST_GPIO
+	fastPinInit(&csnFast, csn, true);
+	fastPinInit(&trxFast, trx, true);
+	fastPinInit(&txFast, tx, true);
+	fastPinInit(&pwrFast, pwr, true);
+	fastPinInit(&cdFast, cd, false);
+	fastPinInit(&amFast, am, false);
+#endif
+
 	digitalWrite(csn, HIGH);
 	pinMode(csn, OUTPUT);
 	if(trx != NRF905_PIN_UNUSED)
@@ -232,13 +396,23 @@ void nRF905::begin(
 	powerOn(false);
 	standbyMode(true);
 	txMode(false);
-	delay(3);
+
+	// If the PWR pin is connected then the radio is left in power-down mode, the config registers can still be written and
+	// .standby(), .RX() and .TX() take care of the power-up time later on (see .wakeRemaining())
+	// Otherwise the radio is always powered up, so wait in case it has only just got power. Setting up the pins above counts towards the wait
+	if(pwr == NRF905_PIN_UNUSED)
+		while((unsigned long)(micros() - start) < NRF905_POWERUP_TIME);
+
 	defaultConfig();
 
+	pollLastState = 0;
+	pollAddrMatch = 0;
+
 	if(dr == NRF905_PIN_UNUSED || callback_interrupt_dr == NULL)
 		polledMode = true;
 	else
 	{
+		polledMode = false;
 		attachInterrupt(digitalPinToInterrupt(dr), callback_interrupt_dr, RISING);
 		if(am != NRF905_PIN_UNUSED && callback_interrupt_am != NULL)
 			attachInterrupt(digitalPinToInterrupt(am), callback_interrupt_am, CHANGE);
@@ -265,32 +439,37 @@ void nRF905::events(
 	this->onAddrMatch = onAddrMatch;
 }
 
-void nRF905::setChannel(uint16_t channel)
+// Bits 0 - 8 are the channel and bit 9 is the band (same layout as the first 2 bytes of the config registers)
+void nRF905::tune(uint16_t channelBand)
 {
-	if(channel > 511)
-		channel = 511;
+	configRegs[NRF905_REG_CHANNEL] = channelBand;
+	configRegs[NRF905_REG_CONFIG1] = (configRegs[NRF905_REG_CONFIG1] & NRF905_MASK_CHANNEL & NRF905_MASK_BAND) | ((channelBand>>8) & 0x03);
 
-	// TODO atomic read/write?
-	uint8_t reg = (readConfigRegister(NRF905_REG_CONFIG1) & NRF905_MASK_CHANNEL) | (channel>>8);
+	if(configBatch)
+	{
+		writeConfig(NRF905_REG_CHANNEL, 2);
+		return;
+	}
 
+	// CHAN_CONFIG sets the channel, band and output power with 2 bytes instead of the 3 needed by W_CONFIG
 	CHIPSELECT()
 	{
-		spi.transfer(NRF905_CMD_W_CONFIG | NRF905_REG_CHANNEL);
-		spi.transfer(channel);
-		spi.transfer(reg);
+		spiTransfer(NRF905_CMD_CHAN_CONFIG | (configRegs[NRF905_REG_CONFIG1] & 0x0F));
+		spiTransfer(configRegs[NRF905_REG_CHANNEL]);
 	}
 }
 
-void nRF905::setBand(nRF905_band_t band)
+void nRF905::setChannel(uint16_t channel)
 {
-	// TODO atomic read/write?
-	uint8_t reg = (readConfigRegister(NRF905_REG_CONFIG1) & NRF905_MASK_BAND) | band;
+	if(channel > 511)
+		channel = 511;
 
-	CHIPSELECT()
-	{
-		spi.transfer(NRF905_CMD_W_CONFIG | NRF905_REG_CONFIG1);
-		spi.transfer(reg);
-	}
+	tune(channel | ((configRegs[NRF905_REG_CONFIG1] & ~NRF905_MASK_BAND)<<8));
+}
+
+void nRF905::setBand(nRF905_band_t band)
+{
+	tune((configRegs[NRF905_REG_CHANNEL] | ((configRegs[NRF905_REG_CONFIG1] & ~NRF905_MASK_CHANNEL)<<8)) | (band<<8));
 }
 
 void nRF905::setAutoRetransmit(bool val)
@@ -302,6 +481,11 @@ void nRF905::setAutoRetransmit(bool val)
 	);
 }
 
+bool nRF905::getAutoRetransmit()
+{
+	return (configRegs[NRF905_REG_CONFIG1] & ~NRF905_MASK_AUTO_RETRAN);
+}
+
 void nRF905::setLowRxPower(bool val)
 {
 	setConfigReg1(
@@ -316,6 +500,11 @@ void nRF905::setTransmitPower(nRF905_pwr_t val)
 	setConfigReg1(val, NRF905_MASK_PWR, NRF905_REG_PWR);
 }
 
+nRF905_pwr_t nRF905::getTransmitPower()
+{
+	return (nRF905_pwr_t)(configRegs[NRF905_REG_CONFIG1] & ~NRF905_MASK_PWR);
+}
+
 void nRF905::setCRC(nRF905_crc_t val)
 {
 	setConfigReg2(val, NRF905_MASK_CRC, NRF905_REG_CRC);
@@ -334,12 +523,20 @@ void nRF905::setPayloadSize(uint8_t sizeTX, uint8_t sizeRX)
 	if(sizeRX > NRF905_MAX_PAYLOAD)
 		sizeRX = NRF905_MAX_PAYLOAD;
 
-	CHIPSELECT()
-	{
-		spi.transfer(NRF905_CMD_W_CONFIG | NRF905_REG_RX_PAYLOAD_SIZE);
-		spi.transfer(sizeRX);
-		spi.transfer(sizeTX);
-	}
+	configRegs[NRF905_REG_RX_PAYLOAD_SIZE] = sizeRX;
+	configRegs[NRF905_REG_TX_PAYLOAD_SIZE] = sizeTX;
+	fixedPayloadSize = sizeTX;
+	writeConfig(NRF905_REG_RX_PAYLOAD_SIZE, 2);
+}
+
+uint8_t nRF905::getPayloadSizeTX()
+{
+	return configRegs[NRF905_REG_TX_PAYLOAD_SIZE] & 0x3F;
+}
+
+uint8_t nRF905::getPayloadSizeRX()
+{
+	return configRegs[NRF905_REG_RX_PAYLOAD_SIZE] & 0x3F;
 }
 
 void nRF905::setAddressSize(uint8_t sizeTX, uint8_t sizeRX)
@@ -350,11 +547,7 @@ void nRF905::setAddressSize(uint8_t sizeTX, uint8_t sizeRX)
 	if(sizeRX != 1 && sizeRX != 4)
 		sizeRX = 4;
 
-	CHIPSELECT()
-	{
-		spi.transfer(NRF905_CMD_W_CONFIG | NRF905_REG_ADDR_WIDTH);
-		spi.transfer((sizeTX<<4) | sizeRX);
-	}
+	writeConfigRegister(NRF905_REG_ADDR_WIDTH, (sizeTX<<4) | sizeRX);
 }
 
 bool nRF905::receiveBusy()
@@ -365,19 +558,114 @@ bool nRF905::receiveBusy()
 bool nRF905::airwayBusy()
 {
 	if(cd != NRF905_PIN_UNUSED)
-		return digitalRead(cd);
+		return PIN_READ(cd);
 	return false;
 }
 
+// Sweep the channels and either fill in occupancy or find the quietest channel
+bool nRF905::scan(uint16_t first, uint16_t last, uint16_t dwell, uint8_t* occupancy, uint16_t* quietest)
+{
+	if(cd == NRF905_PIN_UNUSED)
+		return false;
+
+	if(last > 511)
+		last = 511;
+
+	// Between .beginConfig() and .commitConfig() tune() would only mark the channel as dirty and the whole sweep would stay on one channel,
+	// so send the waiting changes first and carry on batching afterwards
+	bool batch = configBatch;
+	if(batch)
+		commitConfig();
+
+	nRF905_mode_t prevMode = mode();
+	uint8_t prevChannel = configRegs[NRF905_REG_CHANNEL];
+	uint8_t prevConfig1 = configRegs[NRF905_REG_CONFIG1];
+	uint16_t band = (prevConfig1 & ~NRF905_MASK_BAND)<<8;
+	uint8_t quietestOccupancy = 255;
+
+	// Only the CE pin is pulsed for each channel, the radio otherwise stays in receive mode for the whole sweep
+	RX();
+	unsigned int wait = wakeRemaining();
+	unsigned long start = micros();
+	while((unsigned int)(micros() - start) < wait);
+
+	for(uint16_t channel=first;channel<=last;channel++)
+	{
+		// Go through standby so the synthesiser locks onto the new frequency
+		standbyMode(true);
+		tune(channel | band);
+		standbyMode(false);
+
+		start = micros();
+		while((unsigned int)(micros() - start) < NRF905_RX_SETTLE_TIME);
+
+		uint16_t samples = 0;
+		uint16_t busy = 0;
+		start = micros();
+		do
+		{
+			if(PIN_READ(cd))
+				busy++;
+			samples++;
+		}
+		while((unsigned int)(micros() - start) < dwell && samples < 0xFFFF);
+
+		uint8_t percent = ((uint32_t)busy * 100) / samples;
+		if(occupancy != NULL)
+			occupancy[channel - first] = percent;
+		if(quietest != NULL && percent < quietestOccupancy)
+		{
+			quietestOccupancy = percent;
+			*quietest = channel;
+		}
+	}
+
+	// Put everything back
+	standbyMode(true);
+	tune(prevChannel | ((prevConfig1 & ~NRF905_MASK_CHANNEL)<<8) | band);
+	if(prevMode == NRF905_MODE_RX || prevMode == NRF905_MODE_ACTIVE)
+		standbyMode(false);
+	else if(prevMode == NRF905_MODE_POWERDOWN)
+		powerOn(false);
+
+	if(batch)
+		beginConfig();
+
+	return true;
+}
+
+bool nRF905::scanChannels(uint16_t first, uint16_t last, uint16_t dwell, uint8_t* occupancy)
+{
+	return scan(first, last, dwell, occupancy, NULL);
+}
+
+uint16_t nRF905::quietestChannel(uint16_t first, uint16_t last, uint16_t dwell)
+{
+	uint16_t channel = first;
+	scan(first, last, dwell, NULL, &channel);
+	return channel;
+}
+
 void nRF905::setListenAddress(uint32_t address)
 {
-	setAddress(address, NRF905_CMD_W_CONFIG | NRF905_REG_RX_ADDRESS);
+	for(uint8_t i=0;i<4;i++)
+		configRegs[NRF905_REG_RX_ADDRESS + i] = address>>(8 * i);
+	writeConfig(NRF905_REG_RX_ADDRESS, 4);
 }
 
-void nRF905::write(uint32_t sendTo, void* data, uint8_t len)
+void nRF905::setTxAddress(uint32_t sendTo)
 {
+	// Skip the SPI transaction if the radio already has this address
+	if(txAddressValid && txAddress == sendTo)
+		return;
+
 	setAddress(sendTo, NRF905_CMD_W_TX_ADDRESS);
+	txAddress = sendTo;
+	txAddressValid = true;
+}
 
+void nRF905::loadPayload(void* data, uint8_t len)
+{
 	if(len > 0 && data != NULL)
 	{
 		if(len > NRF905_MAX_PAYLOAD)
@@ -385,14 +673,88 @@ void nRF905::write(uint32_t sendTo, void* data, uint8_t len)
 
 		CHIPSELECT()
 		{
-			spi.transfer(NRF905_CMD_W_TX_PAYLOAD);
-			//spi.transfer(data, len);
-			for(uint8_t i=0;i<len;i++)
-				spi.transfer(((uint8_t*)data)[i]);
+			spiTransfer(NRF905_CMD_W_TX_PAYLOAD);
+			spiWrite(data, len);
 		}
 	}
 }
 
+void nRF905::writePayload(void* data, uint8_t len)
+{
+	if(autoPayloadSize && len > 0 && data != NULL)
+	{
+		// Only touch the register if the size is different to what the radio already has
+		uint8_t size = payloadClass(len);
+		if(configRegs[NRF905_REG_TX_PAYLOAD_SIZE] != size)
+		{
+			configRegs[NRF905_REG_TX_PAYLOAD_SIZE] = size;
+			writeConfig(NRF905_REG_TX_PAYLOAD_SIZE, 1);
+		}
+	}
+
+	loadPayload(data, len);
+}
+
+void nRF905::setAutoPayloadSize(bool enable, const uint8_t* classes, uint8_t count)
+{
+	if(enable && !autoPayloadSize)
+		fixedPayloadSize = configRegs[NRF905_REG_TX_PAYLOAD_SIZE];
+	else if(!enable && autoPayloadSize && configRegs[NRF905_REG_TX_PAYLOAD_SIZE] != fixedPayloadSize)
+	{
+		configRegs[NRF905_REG_TX_PAYLOAD_SIZE] = fixedPayloadSize;
+		writeConfig(NRF905_REG_TX_PAYLOAD_SIZE, 1);
+	}
+
+	autoPayloadSize = enable;
+	payloadClasses = classes;
+	payloadClassCount = (classes != NULL) ? count : 0;
+}
+
+uint8_t nRF905::payloadClass(uint8_t len)
+{
+	if(len < 1)
+		len = 1;
+	else if(len > NRF905_MAX_PAYLOAD)
+		len = NRF905_MAX_PAYLOAD;
+
+	if(payloadClassCount == 0)
+		return len;
+
+	// Smallest size that fits
+	for(uint8_t i=0;i<payloadClassCount;i++)
+	{
+		if(payloadClasses[i] >= len)
+			return payloadClasses[i];
+	}
+	return NRF905_MAX_PAYLOAD;
+}
+
+void nRF905::write(uint32_t sendTo, void* data, uint8_t len)
+{
+	setTxAddress(sendTo);
+	writePayload(data, len);
+}
+
+void nRF905::stagePayload(uint32_t sendTo, void* data, uint8_t len)
+{
+	write(sendTo, data, len);
+	txStaged = true;
+}
+
+void nRF905::patchPayload(void* data, uint8_t len)
+{
+	// W_TX_PAYLOAD always starts from the first byte, anything after the last byte written is left as it was
+	// The payload size must stay as it was when the whole payload was written
+	loadPayload(data, len);
+}
+
+bool nRF905::sendStaged(nRF905_nextmode_t nextMode, bool collisionAvoid)
+{
+	if(!txStaged)
+		return false;
+	return TX(nextMode, collisionAvoid);
+}
+
 void nRF905::read(void* data, uint8_t len)
 {
 	if(len > NRF905_MAX_PAYLOAD)
@@ -400,12 +762,10 @@ void nRF905::read(void* data, uint8_t len)
 
 	CHIPSELECT()
 	{
-		spi.transfer(NRF905_CMD_R_RX_PAYLOAD);
+		spiTransfer(NRF905_CMD_R_RX_PAYLOAD);
 
 		// Get received payload
-		//spi.transfer(data, len);
-		for(uint8_t i=0;i<len;i++)
-			((uint8_t*)data)[i] = spi.transfer(NRF905_CMD_NOP);
+		spiRead(data, len);
 
 		// Must make sure all of the payload has been read, otherwise DR never goes low
 		//uint8_t remaining = NRF905_MAX_PAYLOAD - len;
@@ -474,22 +834,77 @@ void nRF905::flush()
 }
 */
 bool nRF905::TX(nRF905_nextmode_t nextMode, bool collisionAvoid)
+{
+	// Finish off anything started by startTX()
+	while(!service());
+
+	if(!startTX(nextMode, collisionAvoid))
+		return false;
+
+	// Use micros() timing (inside service()) instead of delay()/delayMicroseconds() to get better accuracy incase other interrupts happen (which would cause delayMicroseconds() to pause)
+	while(!service());
+
+	return true;
+}
+
+bool nRF905::startTX(nRF905_nextmode_t nextMode, bool collisionAvoid)
 {
 	// TODO check DR is low?
 	// check AM for incoming packet?
 	// what if already in TX mode? (auto-retransmit or carrier wave)
 
+	if(txStage != TXSTAGE_IDLE)
+		return false;
+
+	uint16_t packetTime = 0;
+	if(dutyPerMille)
+	{
+		dutyCycleRefill();
+		packetTime = airtime();
+		if(dutyCredit < packetTime)
+		{
+			STATS_INC(txDutyCycle);
+			return false;
+		}
+	}
+
 	nRF905_mode_t currentMode = mode();
 	if(currentMode == NRF905_MODE_POWERDOWN)
 	{
 		currentMode = NRF905_MODE_STANDBY;
 		standbyMode(true);
 		powerOn(true);
-		if(nextMode != NRF905_NEXTMODE_TX)
-			delay(3); // Delay is needed to the radio has time to power-up and see the standby/TX pins pulse
 	}
 	else if(collisionAvoid && airwayBusy())
+	{
+		STATS_INC(txBusy);
 		return false;
+	}
+
+	dutyCredit -= packetTime;
+
+	if(currentMode == NRF905_MODE_STANDBY && nextMode != NRF905_NEXTMODE_TX)
+	{
+		// Delay is needed to the radio has time to power-up and see the standby/TX pins pulse
+		// Only wait for whatever is left of the power-up time
+		unsigned int wait = wakeRemaining();
+		if(wait)
+		{
+			txWait(TXSTAGE_POWERUP, nextMode, wait);
+			return true;
+		}
+	}
+
+	txBegin(currentMode, nextMode);
+	return true;
+}
+
+void nRF905::txBegin(nRF905_mode_t currentMode, nRF905_nextmode_t nextMode)
+{
+	txStaged = false;
+
+	// DR doesn't go high at the end of the transmission if nextMode is RX
+	txActive = (nextMode != NRF905_NEXTMODE_RX);
 
 	// Put into transmit mode
 	txMode(true); //PORTB |= _BV(PORTB1);
@@ -498,9 +913,9 @@ bool nRF905::TX(nRF905_nextmode_t nextMode, bool collisionAvoid)
 	if(currentMode == NRF905_MODE_STANDBY)
 		standbyMode(false); //PORTD |= _BV(PORTD7);
 	
-	// NOTE: If nextMode is RX or STANDBY and a long running interrupt happens during the delays below then
-	// we may end up transmitting a blank carrier wave until the interrupt ends.
-	// If nextMode is RX then an unexpected onTxComplete event will also fire and RX mode won't be entered until the interrupt finishes.
+	// NOTE: If nextMode is RX or STANDBY and service() isn't called (or a long running interrupt happens) before the wait below has passed and the payload has been sent then
+	// we may end up transmitting a blank carrier wave (or retransmitting the payload if auto-retransmit is on) until service() is called.
+	// If nextMode is RX then an unexpected onTxComplete event will also fire and RX mode won't be entered until service() is called.
 
 	if(nextMode == NRF905_NEXTMODE_RX)
 	{
@@ -508,29 +923,62 @@ bool nRF905::TX(nRF905_nextmode_t nextMode, bool collisionAvoid)
 		//	a transmission is complete by clearing TX_EN while transmitting, but if the radio was
 		//	in standby mode and TX_EN is cleared within ~700us then the transmission seems to get corrupt.
 		// 2.	Going straight to RX also stops DR from pulsing after transmission complete which means the onTxComplete event doesn't work
-		if(currentMode == NRF905_MODE_STANDBY)
-		{
-			// Use micros() timing here instead of delayMicroseconds() to get better accuracy incase other interrupts happen (which would cause delayMicroseconds() to pause)
-			unsigned int start = micros();
-			while((unsigned int)(micros() - start) < 700);
-		}
-		else
-			delayMicroseconds(14);
-		txMode(false); //PORTB &= ~_BV(PORTB1);
+		txWait(TXSTAGE_NEXTMODE, nextMode, (currentMode == NRF905_MODE_STANDBY) ? 700 : 14);
 	}
 	else if(nextMode == NRF905_NEXTMODE_STANDBY)
+		txWait(TXSTAGE_NEXTMODE, nextMode, 14);
+	// else NRF905_NEXTMODE_TX
+}
+
+void nRF905::txWait(uint8_t stage, nRF905_nextmode_t nextMode, unsigned int time)
+{
+	txNextMode = nextMode;
+	txWaitTime = time;
+	txWaitStart = micros();
+	txStage = stage;
+}
+
+bool nRF905::service()
+{
+#if NRF905_TX_QUEUE_SLOTS
+	// Send the next queued payload once the DR interrupt (or .poll()) has seen the previous one finish
+	// The DR interrupt can't fire again until this one has been sent, so there's no race with txQueueComplete()
+	if(txQueueReady && txStage == TXSTAGE_IDLE)
+	{
+		txQueueReady = false;
+		txQueueSendNext();
+	}
+#endif
+
+	// The DR interrupt can also call this, make sure only one of them moves on to the next stage
+	// This also runs inside the DR interrupt, so interrupts must be left disabled if they already were
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	uint8_t stage = txStage;
+	if(stage == TXSTAGE_IDLE || (unsigned int)(micros() - txWaitStart) < txWaitTime)
+	{
+		nRF905_irqRestore(irq);
+		return (stage == TXSTAGE_IDLE);
+	}
+	txStage = TXSTAGE_IDLE;
+	nRF905_irqRestore(irq);
+
+	if(stage == TXSTAGE_POWERUP)
+		txBegin(NRF905_MODE_STANDBY, txNextMode);
+	else if(txNextMode == NRF905_NEXTMODE_RX)
+		txMode(false); //PORTB &= ~_BV(PORTB1);
+	else
 	{
-		delayMicroseconds(14);
 		standbyMode(true);
 		//txMode(false);
 	}
-	// else NRF905_NEXTMODE_TX
 
-	return true;
+	return (txStage == TXSTAGE_IDLE);
 }
 
 void nRF905::RX()
 {
+	txStage = TXSTAGE_IDLE;
+	txActive = false;
 	txMode(false);
 	standbyMode(false);
 	powerOn(true);
@@ -538,11 +986,146 @@ void nRF905::RX()
 
 void nRF905::powerDown()
 {
+	txStage = TXSTAGE_IDLE;
+	txActive = false;
 	powerOn(false);
 }
 
+bool nRF905::transmitting()
+{
+	return txActive;
+}
+
+bool nRF905::waitTX(uint16_t timeout)
+{
+	unsigned long start = millis();
+	while(!service() || transmitting())
+	{
+		if((unsigned long)(millis() - start) >= timeout)
+			return false;
+		if(polledMode)
+			poll();
+	}
+	return true;
+}
+
+bool nRF905::TXWhenClear(nRF905_nextmode_t nextMode, uint16_t timeout)
+{
+	unsigned long start = millis();
+	while(!TX(nextMode, true))
+	{
+		if((unsigned long)(millis() - start) >= timeout)
+			return false;
+
+		// Random wait so radios that were waiting for the same transmission to finish don't all start at once
+		delayMicroseconds(random(NRF905_TX_SETTLE_TIME + NRF905_CALC_AIRTIME(0, 0, 0)));
+
+		if(polledMode)
+			poll();
+	}
+	return true;
+}
+
+void nRF905::prepareWake()
+{
+	if(mode() == NRF905_MODE_POWERDOWN)
+	{
+		standbyMode(true);
+		powerOn(true);
+	}
+}
+
+unsigned int nRF905::wakeRemaining()
+{
+	if(!powerUpWait)
+		return 0;
+
+	unsigned long elapsed = micros() - powerUpTime;
+	if(elapsed >= NRF905_POWERUP_TIME)
+	{
+		powerUpWait = false;
+		return 0;
+	}
+
+	return NRF905_POWERUP_TIME - elapsed;
+}
+
+uint8_t nRF905::crcSize()
+{
+	if((configRegs[NRF905_REG_CONFIG2] & ~NRF905_MASK_CRC) == NRF905_CRC_16)
+		return 2;
+	else if((configRegs[NRF905_REG_CONFIG2] & ~NRF905_MASK_CRC) == NRF905_CRC_8)
+		return 1;
+	return 0;
+}
+
+uint16_t nRF905::airtime()
+{
+	uint8_t addrSize = (configRegs[NRF905_REG_ADDR_WIDTH]>>4) & 0x07;
+	uint8_t payloadSize = configRegs[NRF905_REG_TX_PAYLOAD_SIZE] & 0x3F;
+	return NRF905_CALC_AIRTIME(addrSize, payloadSize, crcSize());
+}
+
+uint16_t nRF905::rxAirtime()
+{
+	uint8_t addrSize = configRegs[NRF905_REG_ADDR_WIDTH] & 0x07;
+	uint8_t payloadSize = configRegs[NRF905_REG_RX_PAYLOAD_SIZE] & 0x3F;
+	return NRF905_CALC_AIRTIME(addrSize, payloadSize, crcSize());
+}
+
+uint16_t nRF905::maxPacketRate()
+{
+	return 1000000UL / (airtime() + NRF905_TX_SETTLE_TIME);
+}
+
+uint16_t nRF905::maxGoodput()
+{
+	return maxPacketRate() * (configRegs[NRF905_REG_TX_PAYLOAD_SIZE] & 0x3F);
+}
+
+void nRF905::setDutyCycle(uint16_t perMille)
+{
+	if(perMille > 1000)
+		perMille = 1000;
+
+	// Start with a full hour's worth of airtime
+	dutyPerMille = perMille;
+	dutyCredit = 3600000UL * perMille;
+	dutyUpdated = millis();
+}
+
+void nRF905::dutyCycleRefill()
+{
+	unsigned long now = millis();
+	unsigned long elapsed = now - dutyUpdated;
+	dutyUpdated = now;
+
+	// perMille microseconds of airtime are earned each millisecond up to an hour's worth (3.6 billion at most, fits in 32 bits)
+	// Only count the time needed to fill the budget back up, otherwise the credit could go past 32 bits and wrap around
+	uint32_t max = 3600000UL * dutyPerMille;
+	uint32_t fill = (max - dutyCredit) / dutyPerMille;
+	if(elapsed >= fill)
+		dutyCredit = max;
+	else
+		dutyCredit += elapsed * dutyPerMille;
+}
+
+uint32_t nRF905::dutyCycleWait()
+{
+	if(!dutyPerMille)
+		return 0;
+
+	dutyCycleRefill();
+	uint16_t packetTime = airtime();
+	if(dutyCredit >= packetTime)
+		return 0;
+
+	return ((packetTime - dutyCredit) + dutyPerMille - 1) / dutyPerMille;
+}
+
 void nRF905::standby()
 {
+	txStage = TXSTAGE_IDLE;
 	standbyMode(true);
 	powerOn(true);
 }
@@ -551,19 +1134,19 @@ nRF905_mode_t nRF905::mode()
 {
 	if(pwr != NRF905_PIN_UNUSED)
 	{
-		if(!digitalRead(pwr))
+		if(!PIN_READ(pwr))
 			return NRF905_MODE_POWERDOWN;
 	}
 	
 	if(trx != NRF905_PIN_UNUSED)
 	{
-		if(!digitalRead(trx))
+		if(!PIN_READ(trx))
 			return NRF905_MODE_STANDBY;
 	}
 
 	if(tx != NRF905_PIN_UNUSED)
 	{
-		if(digitalRead(tx))
+		if(PIN_READ(tx))
 			return NRF905_MODE_TX;
 		return NRF905_MODE_RX;
 	}
@@ -589,33 +1172,290 @@ void nRF905::getConfigRegisters(void* regs)
 {
 	CHIPSELECT()
 	{
-		spi.transfer(NRF905_CMD_R_CONFIG);
-		for(uint8_t i=0;i<NRF905_REGISTER_COUNT;i++)
-			((uint8_t*)regs)[i] = spi.transfer(NRF905_CMD_NOP);
+		spiTransfer(NRF905_CMD_R_CONFIG);
+		spiRead(regs, NRF905_REGISTER_COUNT);
+	}
+
+	// Whatever the radio says is the truth
+	memcpy(configRegs, regs, NRF905_REGISTER_COUNT);
+}
+
+void nRF905::resyncConfig()
+{
+	writeConfig(0, NRF905_REGISTER_COUNT);
+
+	// TX address is probably gone too
+	txAddressValid = false;
+}
+
+void nRF905::beginConfig()
+{
+	configBatch = true;
+}
+
+void nRF905::commitConfig()
+{
+	configBatch = false;
+
+	if(!configDirty)
+		return;
+
+	// Smallest contiguous range covering all dirty registers
+	uint8_t first = 0;
+	while(!(configDirty & (1<<first)))
+		first++;
+
+	uint8_t last = NRF905_REGISTER_COUNT - 1;
+	while(!(configDirty & (1<<last)))
+		last--;
+
+	configDirty = 0;
+
+	writeConfig(first, (last - first) + 1);
+}
+
+unsigned long nRF905::rxTimestamp()
+{
+	// Can't be read in one go on 8 bit MCUs, this is also called from inside the onRxComplete event
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	unsigned long time = rxTime;
+	nRF905_irqRestore(irq);
+	return time;
+}
+
+unsigned long nRF905::addrMatchTimestamp()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	unsigned long time = amTime;
+	nRF905_irqRestore(irq);
+	return time;
+}
+
+unsigned long nRF905::txTimestamp()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	unsigned long time = txTime;
+	nRF905_irqRestore(irq);
+	return time;
+}
+
+#if NRF905_RX_BUFFER_SLOTS
+// Only called from interrupt_dr() or poll() (producer)
+void nRF905::bufferPayload()
+{
+	uint8_t len = configRegs[NRF905_REG_RX_PAYLOAD_SIZE];
+
+	if((uint8_t)(rxHead - rxTail) >= NRF905_RX_BUFFER_SLOTS)
+	{
+		// Buffer full, the payload must still be read out of the radio otherwise DR will stay high and nothing else will be received
+		rxOverflows++;
+		CHIPSELECT()
+		{
+			spiTransfer(NRF905_CMD_R_RX_PAYLOAD);
+			for(uint8_t i=0;i<len;i++)
+				spiTransfer(NRF905_CMD_NOP);
+		}
+		return;
 	}
+
+	nRF905_packet_t* packet = &rxBuffer[rxHead & (NRF905_RX_BUFFER_SLOTS - 1)];
+	packet->len = len;
+	packet->timestamp = rxTime;
+	read(packet->data, len);
+
+	// Make sure the payload is in the buffer before the consumer can see it
+	NRF905_MEMORY_BARRIER();
+	rxHead++;
+}
+
+uint8_t nRF905::available()
+{
+	return rxHead - rxTail;
+}
+
+uint8_t nRF905::readPacket(void* data, uint8_t len, unsigned long* timestamp)
+{
+	if(rxHead == rxTail)
+		return 0;
+
+	nRF905_packet_t* packet = &rxBuffer[rxTail & (NRF905_RX_BUFFER_SLOTS - 1)];
+	if(len > packet->len)
+		len = packet->len;
+	memcpy(data, packet->data, len);
+	if(timestamp != NULL)
+		*timestamp = packet->timestamp;
+
+	// Make sure the payload has been copied before the producer can reuse the slot
+	NRF905_MEMORY_BARRIER();
+	rxTail++;
+
+	return len;
 }
 
+uint16_t nRF905::rxOverflowCount()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	uint16_t count = rxOverflows;
+	nRF905_irqRestore(irq);
+	return count;
+}
+#endif
+
+#if NRF905_TX_QUEUE_SLOTS
+// Write the next queued payload to the radio and start sending it
+void nRF905::txQueueSendNext()
+{
+	txitem_t* item = &txQueue[txTail & (NRF905_TX_QUEUE_SLOTS - 1)];
+	write(item->sendTo, item->data, item->len);
+
+	// Next mode must be standby so that DR goes high when the transmission is complete, service() finishes the mode change
+	// If the duty cycle budget has run out then the queue stops until the next .enqueue()
+	if(!startTX(NRF905_NEXTMODE_STANDBY, false))
+		txQueueBusy = false;
+}
+
+// Only called from interrupt_dr() or poll() when a transmission completes
+// The next payload isn't sent from here, that would mean SPI transfers and waiting for the radio inside the interrupt, service() sends it instead
+void nRF905::txQueueComplete()
+{
+	if(!txQueueBusy)
+		return;
+
+	txTail++;
+
+	if(txHead != txTail)
+		txQueueReady = true;
+	else
+	{
+		txQueueBusy = false;
+		if(txQueueNextMode == NRF905_NEXTMODE_RX)
+			RX();
+	}
+}
+
+int16_t nRF905::enqueue(uint32_t sendTo, void* data, uint8_t len)
+{
+	if((uint8_t)(txHead - txTail) >= NRF905_TX_QUEUE_SLOTS)
+		return -1;
+
+	if(len > NRF905_MAX_PAYLOAD)
+		len = NRF905_MAX_PAYLOAD;
+
+	txitem_t* item = &txQueue[txHead & (NRF905_TX_QUEUE_SLOTS - 1)];
+	item->sendTo = sendTo;
+	item->len = len;
+	memcpy(item->data, data, len);
+
+	// Make sure the item is in the queue before the DR interrupt can see it
+	NRF905_MEMORY_BARRIER();
+	uint8_t id = ++txHead;
+
+	// If the queue was idle then nothing is going to start the transmission for us
+	// (if the queue was busy then .service() will pick up the new item once the current transmission completes)
+	if(!txQueueBusy)
+	{
+		txQueueBusy = true;
+		txQueueSendNext();
+	}
+
+	return id;
+}
+
+uint8_t nRF905::txQueueLength()
+{
+	return txHead - txTail;
+}
+
+bool nRF905::txQueueSent(uint8_t id)
+{
+	return (int8_t)(txTail - id) >= 0;
+}
+
+void nRF905::setTxQueueNextMode(nRF905_nextmode_t nextMode)
+{
+	txQueueNextMode = nextMode;
+}
+#endif
+
+void nRF905::runEvent(void (*event)(nRF905* device))
+{
+	if(event == NULL)
+		return;
+
+#if NRF905_STATS
+	unsigned long start = micros();
+	event(this);
+	stats.events++;
+	statsTime(micros() - start, &stats.eventTimeMax, &stats.eventTimeTotal);
+#else
+	event(this);
+#endif
+}
+
+#if NRF905_STATS
+void nRF905::statsTime(uint32_t time, uint32_t* max, uint32_t* total)
+{
+	if(time > *max)
+		*max = time;
+	*total += time;
+}
+
+void nRF905::getStats(nRF905_stats_t* stats)
+{
+	// Interrupts could be updating the stats
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	memcpy(stats, &this->stats, sizeof(nRF905_stats_t));
+	nRF905_irqRestore(irq);
+}
+
+void nRF905::resetStats()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	memset(&stats, 0, sizeof(nRF905_stats_t));
+	nRF905_irqRestore(irq);
+}
+#endif
+
 void nRF905::interrupt_dr()
 {
 	// If DR && AM = RX new packet
 	// If DR && !AM = TX finished
 	
+	// Timestamp first so it's as close to the DR edge as possible
+	unsigned long start = micros();
+
 #if defined(ESP32) || defined(ESP8266)
 	isrBusy = 1;
 #endif
+#if NRF905_STATS
+	stats.isrDr++;
+#endif
 
 	if(addressMatched())
 	{
+		rxTime = start;
 		validPacket = 1;
-		if(onRxComplete != NULL)
-			onRxComplete(this);
+		STATS_INC(rxComplete);
+#if NRF905_RX_BUFFER_SLOTS
+		bufferPayload();
+#endif
+		runEvent(onRxComplete);
 	}
 	else
 	{
-		if(onTxComplete != NULL)
-			onTxComplete(this);
+		txTime = start;
+		STATS_INC(txComplete);
+		txActive = false;
+		service();
+#if NRF905_TX_QUEUE_SLOTS
+		txQueueComplete();
+#endif
+		runEvent(onTxComplete);
 	}
 
+#if NRF905_STATS
+	statsTime(micros() - start, &stats.isrDrTimeMax, &stats.isrDrTimeTotal);
+#endif
 #if defined(ESP32) || defined(ESP8266)
 	isrBusy = 0;
 #endif
@@ -625,22 +1465,31 @@ void nRF905::interrupt_am()
 {
 	// If AM goes HIGH then LOW without DR going HIGH then we got a bad packet
 
+	unsigned long start = micros();
+
 #if defined(ESP32) || defined(ESP8266)
 	isrBusy = 1;
 #endif
+#if NRF905_STATS
+	stats.isrAm++;
+#endif
 
 	if(addressMatched())
 	{
-		if(onAddrMatch != NULL)
-			onAddrMatch(this);
+		amTime = start;
+		STATS_INC(addrMatch);
+		runEvent(onAddrMatch);
 	}
 	else if(!validPacket)
 	{
-		if(onRxInvalid != NULL)
-			onRxInvalid(this);
+		STATS_INC(rxInvalid);
+		runEvent(onRxInvalid);
 	}
 	validPacket = 0;
 
+#if NRF905_STATS
+	statsTime(micros() - start, &stats.isrAmTimeMax, &stats.isrAmTimeTotal);
+#endif
 #if defined(ESP32) || defined(ESP8266)
 	isrBusy = 0;
 #endif
@@ -651,40 +1500,65 @@ void nRF905::poll()
 	if(!polledMode)
 		return;
 
-	static uint8_t lastState;
-	static uint8_t addrMatch;
-
 // TODO read pins if am / dr defined
 
-	uint8_t state = readStatus() & ((1<<NRF905_STATUS_DR)|(1<<NRF905_STATUS_AM));
+	unsigned long now = micros();
+	pollState(readStatus(), now);
+}
+
+void nRF905::pollState(uint8_t state, unsigned long now)
+{
+	if(!polledMode)
+		return;
+
+	state &= ((1<<NRF905_STATUS_DR)|(1<<NRF905_STATUS_AM));
 
-	if(state != lastState)
+	if(state != pollLastState)
 	{
 		if(state == ((1<<NRF905_STATUS_DR)|(1<<NRF905_STATUS_AM)))
 		{
-			addrMatch = 0;
-			if(onRxComplete != NULL)
-				onRxComplete(this);
+			// AM and DR both went high since the last poll, the address must have matched some time before
+			if(!(pollLastState & (1<<NRF905_STATUS_AM)))
+				amTime = now;
+			rxTime = now;
+			pollAddrMatch = 0;
+			STATS_INC(rxComplete);
+#if NRF905_RX_BUFFER_SLOTS
+			bufferPayload();
+#endif
+			runEvent(onRxComplete);
 		}
 		else if(state == (1<<NRF905_STATUS_DR))
 		{
-			addrMatch = 0;
-			if(onTxComplete != NULL)
-				onTxComplete(this);
+			txTime = now;
+			pollAddrMatch = 0;
+			STATS_INC(txComplete);
+			txActive = false;
+			service();
+#if NRF905_TX_QUEUE_SLOTS
+			txQueueComplete();
+#endif
+			runEvent(onTxComplete);
 		}
 		else if(state == (1<<NRF905_STATUS_AM))
 		{
-			addrMatch = 1;
-			if(onAddrMatch != NULL)
-				onAddrMatch(this);
+			amTime = now;
+			pollAddrMatch = 1;
+			STATS_INC(addrMatch);
+			runEvent(onAddrMatch);
 		}
-		else if(state == 0 && addrMatch)
+		else if(state == 0 && pollAddrMatch)
 		{
-			addrMatch = 0;
-			if(onRxInvalid != NULL)
-				onRxInvalid(this);
+			pollAddrMatch = 0;
+			STATS_INC(rxInvalid);
+			runEvent(onRxInvalid);
 		}
 		
-		lastState = state;
+		pollLastState = state;
 	}
 }
+
+bool nRF905::polled()
+{
+	return polledMode;
+}
@@ -93,10 +93,57 @@ typedef enum
 #define NRF905_DEFAULT_RXADDR	0xE7E7E7E7 ///< Default receive address
 #define NRF905_DEFAULT_TXADDR	0xE7E7E7E7 ///< Default transmit/destination address
 #define NRF905_PIN_UNUSED		255 ///< Mark a pin as not used or not connected
+#define NRF905_TX_TIMEOUT		10 ///< Longest a transmission can take from starting to DR going high (ms), a 32 byte payload with 4 byte address and 16 bit CRC is around 6.3ms plus 650us to settle
+
+/**
+* @brief A received payload held in the receive buffer (see \p NRF905_RX_BUFFER_SLOTS in nRF905_config.h)
+*/
+typedef struct
+{
+	uint8_t len; ///< Payload length
+	uint8_t data[NRF905_MAX_PAYLOAD]; ///< Payload data
+	unsigned long timestamp; ///< micros() when the payload finished arriving (DR went high)
+} nRF905_packet_t;
+
+/**
+* @brief Statistics (see \p NRF905_STATS in nRF905_config.h)
+*
+* Times are in microseconds. Averages can be worked out by dividing the total time by the count, for example \p isrDrTimeTotal / \p isrDr.
+*/
+typedef struct
+{
+	uint32_t rxComplete; ///< Valid payloads received
+	uint32_t rxInvalid; ///< Address matched but payload was bad (AM dropped without DR)
+	uint32_t txComplete; ///< Transmissions completed
+	uint32_t addrMatch; ///< Address matches
+	uint32_t txBusy; ///< Transmissions refused by .TX() because of collision avoidance
+	uint32_t txDutyCycle; ///< Transmissions refused by .TX() because the duty cycle budget ran out
+	uint32_t isrDr; ///< DR interrupts
+	uint32_t isrAm; ///< AM interrupts
+	uint32_t events; ///< Event functions run
+	uint32_t spiTransactions; ///< SPI transactions (chip select cycles)
+	uint32_t spiBytes; ///< SPI bytes transferred
+	uint32_t isrDrTimeMax; ///< Longest time spent in .interrupt_dr()
+	uint32_t isrDrTimeTotal; ///< Total time spent in .interrupt_dr()
+	uint32_t isrAmTimeMax; ///< Longest time spent in .interrupt_am()
+	uint32_t isrAmTimeTotal; ///< Total time spent in .interrupt_am()
+	uint32_t eventTimeMax; ///< Longest time spent in an event function
+	uint32_t eventTimeTotal; ///< Total time spent in event functions
+} nRF905_stats_t;
+
+#if NRF905_FAST_GPIO
+// Port register and bit mask of a pin for direct port access
+typedef struct
+{
+	volatile uint8_t* reg;
+	uint8_t mask;
+} nRF905_fastpin_t;
+#endif
 
 #define NRF905_CALC_CHANNEL(f, b)	((((f) / (1 + (b>>1))) - 422400000UL) / 100000UL) ///< Workout channel from frequency & band
+#define NRF905_CALC_AIRTIME(a, p, c)	((10 + (((a) + (p) + (c)) * 8)) * 20UL) ///< Workout how long a packet is on air in microseconds from address size, payload size & CRC size (0, 1 or 2 bytes), 10 bit preamble and 50Kbps
 
-class nRF905 //: public Stream // TODO see Wire library
+class nRF905 // See nRF905Stream for a Stream interface
 {
 private:
 	SPIClass spi;
@@ -114,6 +161,15 @@ private:
 	uint8_t cd; // Carrier detect (CD)
 	uint8_t dr; // Data ready (DR)
 	uint8_t am; // Address match (AM)
+
+#if NRF905_FAST_GPIO
+	nRF905_fastpin_t csnFast;
+	nRF905_fastpin_t trxFast;
+	nRF905_fastpin_t txFast;
+	nRF905_fastpin_t pwrFast;
+	nRF905_fastpin_t cdFast;
+	nRF905_fastpin_t amFast;
+#endif
 	
 	// Events
 	void (*onRxComplete)(nRF905* device);
@@ -124,18 +180,105 @@ private:
 	volatile uint8_t validPacket;
 	bool polledMode;
 
+	// micros() when DR/AM last went high, recorded by interrupt_dr()/interrupt_am() or poll()
+	volatile unsigned long rxTime;
+	volatile unsigned long txTime;
+	volatile unsigned long amTime;
+
+	// Polled mode state
+	uint8_t pollLastState;
+	uint8_t pollAddrMatch;
+
+	// Shadow copy of the configuration registers so setters don't need to read them back over SPI
+	uint8_t configRegs[NRF905_REGISTER_COUNT];
+	uint16_t configDirty; // Bit mask of registers changed since .beginConfig()
+	bool configBatch;
+
+#if NRF905_RX_BUFFER_SLOTS
+	// Receive buffer, rxHead is only modified by the DR interrupt/.poll() and rxTail only by .readPacket()
+	nRF905_packet_t rxBuffer[NRF905_RX_BUFFER_SLOTS];
+	volatile uint8_t rxHead;
+	volatile uint8_t rxTail;
+	volatile uint16_t rxOverflows;
+	void bufferPayload();
+#endif
+
+#if NRF905_TX_QUEUE_SLOTS
+	typedef struct
+	{
+		uint32_t sendTo;
+		uint8_t len;
+		uint8_t data[NRF905_MAX_PAYLOAD];
+	} txitem_t;
+
+	// Transmit queue, txHead is only modified by .enqueue() and txTail only by the DR interrupt/.poll()
+	txitem_t txQueue[NRF905_TX_QUEUE_SLOTS];
+	volatile uint8_t txHead;
+	volatile uint8_t txTail;
+	volatile bool txQueueBusy;
+	volatile bool txQueueReady; // Previous payload has been sent and the next one is waiting for service() to send it
+	nRF905_nextmode_t txQueueNextMode;
+	void txQueueSendNext();
+	void txQueueComplete();
+#endif
+
+	// Transmission started by startTX() waiting for service()
+	volatile uint8_t txStage;
+	nRF905_nextmode_t txNextMode;
+	unsigned int txWaitStart;
+	unsigned int txWaitTime;
+	void txBegin(nRF905_mode_t currentMode, nRF905_nextmode_t nextMode);
+	void txWait(uint8_t stage, nRF905_nextmode_t nextMode, unsigned int time);
+
+	// Payload from stagePayload() is waiting to be sent
+	volatile bool txStaged;
+
+	// Transmission has started and DR hasn't gone high yet
+	volatile bool txActive;
+
+	// Set TX payload size from the length passed to write()
+	bool autoPayloadSize;
+	uint8_t fixedPayloadSize; // From setPayloadSize(), put back when auto payload size is disabled
+	const uint8_t* payloadClasses;
+	uint8_t payloadClassCount;
+	void loadPayload(void* data, uint8_t len);
+
+	// When the radio was last powered up
+	unsigned long powerUpTime;
+	bool powerUpWait;
+
+	// Duty cycle limit, airtime is earned at dutyPerMille microseconds per millisecond up to an hour's worth
+	uint16_t dutyPerMille;
+	uint32_t dutyCredit; // Microseconds of airtime that can be used
+	unsigned long dutyUpdated;
+	void dutyCycleRefill();
+
+	// Last destination address written to the radio
+	uint32_t txAddress;
+	bool txAddressValid;
+
 	inline uint8_t cselect();
 	inline uint8_t cdeselect();
-	uint8_t readConfigRegister(uint8_t reg);
+	inline uint8_t spiTransfer(uint8_t data);
+	void spiWrite(const void* data, uint8_t len);
+	void spiRead(void* data, uint8_t len);
+	void writeConfig(uint8_t reg, uint8_t count);
 	void writeConfigRegister(uint8_t reg, uint8_t val);
 	void setConfigReg1(uint8_t val, uint8_t mask, uint8_t reg);
 	void setConfigReg2(uint8_t val, uint8_t mask, uint8_t reg);
+	bool scan(uint16_t first, uint16_t last, uint16_t dwell, uint8_t* occupancy, uint16_t* quietest);
 	void defaultConfig();
 	inline void powerOn(bool val);
 	inline void standbyMode(bool val);
 	inline void txMode(bool val);
 	void setAddress(uint32_t address, uint8_t cmd);
-	uint8_t readStatus();
+	uint8_t crcSize();
+	void runEvent(void (*event)(nRF905* device));
+
+#if NRF905_STATS
+	nRF905_stats_t stats;
+	void statsTime(uint32_t time, uint32_t* max, uint32_t* total);
+#endif
 	//bool dataReady();
 	bool addressMatched();
 
@@ -249,6 +392,18 @@ public:
 */
 	void setBand(nRF905_band_t band);
 
+/**
+* @brief Set the channel and band together
+*
+* Same as calling .setChannel() and .setBand(), but only needs one 2 byte SPI transaction. Used by nRF905Hop to hop quickly.
+*
+* Example: `transceiver.tune(117 | (NRF905_BAND_433<<8));`
+*
+* @param [channelBand] Bits 0 - 8 are the channel (0 - 511) and bit 9 is the band (see ::nRF905_band_t), same layout as the first 2 configuration registers
+* @return (none)
+*/
+	void tune(uint16_t channelBand);
+
 /**
 * @brief Set auto-retransmit
 *
@@ -266,6 +421,15 @@ public:
 */
 	void setAutoRetransmit(bool val);
 
+/**
+* @brief See if auto-retransmit is enabled
+*
+* Example: `bool autoRetransmit = transceiver.getAutoRetransmit();`
+*
+* @return \p true if enabled, otherwise \p false
+*/
+	bool getAutoRetransmit();
+
 /**
 * @brief Set low power receive mode
 *
@@ -290,6 +454,15 @@ public:
 */
 	void setTransmitPower(nRF905_pwr_t val);
 
+/**
+* @brief Get the current output power
+*
+* Example: `nRF905_pwr_t power = transceiver.getTransmitPower();`
+*
+* @return Output power, see ::nRF905_pwr_t
+*/
+	nRF905_pwr_t getTransmitPower();
+
 /**
 * @brief Set CRC algorithm
 *
@@ -331,6 +504,59 @@ public:
 */
 	void setPayloadSize(uint8_t sizeTX, uint8_t sizeRX);
 
+/**
+* @brief Get the current transmit payload size
+*
+* Example: `uint8_t size = transceiver.getPayloadSizeTX();`
+*
+* @return Payload size (0 - 32)
+*/
+	uint8_t getPayloadSizeTX();
+
+/**
+* @brief Get the current receive payload size
+*
+* Example: `uint8_t size = transceiver.getPayloadSizeRX();`
+*
+* @return Payload size (0 - 32)
+*/
+	uint8_t getPayloadSizeRX();
+
+/**
+* @brief Set the transmit payload size from the length passed to .write() and .writePayload()
+*
+* Shorter payloads take less time to send (each byte takes 160us at 50Kbps) so short messages don't need to be padded out to 32 bytes.
+* The size is only sent to the radio when it changes.
+*
+* The receiving end must still be set to the same payload size with .setPayloadSize(), so the length is rounded up to the smallest size in \p classes that fits.
+* Receivers then listen with one of the sizes in the list, for example each size could use its own listen address, or a receiver that has been given the same list can use .payloadClass() to work out which size to use for the messages it expects.
+* If \p classes is \p NULL then the payload size is set to exactly \p len.
+*
+* Don't use this with nRF905Stream, nRF905Link or nRF905Aggregator, they need a fixed payload size.
+*
+* Example:\n
+* `static const uint8_t classes[] = {4, 8, 16, 32};`\n
+* `transceiver.setAutoPayloadSize(true, classes, sizeof(classes));`
+*
+* @param [enable] \p true to enable, \p false to go back to the payload size set by .setPayloadSize()
+* @param [classes] List of payload sizes from smallest to largest, must stay valid while enabled (or \p NULL)
+* @param [count] Number of sizes in \p classes
+* @return (none)
+*/
+	void setAutoPayloadSize(bool enable, const uint8_t* classes = NULL, uint8_t count = 0);
+
+/**
+* @brief Payload size that would be used for a message of \p len bytes, see .setAutoPayloadSize()
+*
+* Example:\n
+* `transceiver.setAutoPayloadSize(true, classes, sizeof(classes));`\n
+* `transceiver.setPayloadSize(32, transceiver.payloadClass(sizeof(sensorReading_t)));`
+*
+* @param [len] Message length
+* @return Payload size
+*/
+	uint8_t payloadClass(uint8_t len);
+
 /**
 * @brief Address sizes
 *
@@ -364,6 +590,44 @@ public:
 */
 	bool airwayBusy();
 
+/**
+* @brief Measure how busy a range of channels are
+*
+* The radio is put into receive mode and tuned to each channel in turn, the carrier detect pin is then read as often as possible for \p dwell microseconds.
+* Each channel takes around 650us to settle plus the dwell time, so a full sweep of all 512 channels with a dwell time of 250us takes under half a second.
+* Afterwards the radio goes back to the channel and mode (receive, standby or power-down) it was in before.
+*
+* If this is called between .beginConfig() and .commitConfig() then the changes made so far are sent to the radio first, so the sweep uses them (the band for instance).
+* Changes made after this are batched up again until .commitConfig().
+*
+* Only works if the CD pin is connected. Don't call this while a transmission is going on.
+*
+* Example: `uint8_t occupancy[100]; transceiver.scanChannels(0, 99, 250, occupancy);`
+*
+* @param [first] First channel to scan (0 - 511)
+* @param [last] Last channel to scan (\p first - 511)
+* @param [dwell] How long to listen on each channel (us)
+* @param [occupancy] Buffer of at least \p last - \p first + 1 bytes to put the percentage of carrier detect readings that were high for each channel into (0 - 100)
+* @return \p false if the CD pin isn't connected, otherwise \p true
+*
+* @see .quietestChannel()
+*/
+	bool scanChannels(uint16_t first, uint16_t last, uint16_t dwell, uint8_t* occupancy);
+
+/**
+* @brief Find the least busy channel in a range
+*
+* Same as .scanChannels() but without needing a buffer. If more than one channel is as quiet then the lowest one is returned.
+*
+* Example: `transceiver.setChannel(transceiver.quietestChannel(0, 511, 1000));`
+*
+* @param [first] First channel to scan (0 - 511)
+* @param [last] Last channel to scan (\p first - 511)
+* @param [dwell] How long to listen on each channel (us)
+* @return The quietest channel, or \p first if the CD pin isn't connected
+*/
+	uint16_t quietestChannel(uint16_t first, uint16_t last, uint16_t dwell);
+
 /**
 * @brief Set address to listen to
 *
@@ -386,15 +650,93 @@ public:
 * This also means that a node may receive part of a payload that was meant for a node with a different address.\n
 * Use the \p onTxComplete event to set a flag or something to ensure the transmission is complete before writing another payload. However this only works if \p nextMode is set to ::NRF905_NEXTMODE_TX or ::NRF905_NEXTMODE_STANDBY.
 *
+* The destination address is only sent to the radio if it is different to the last one, see .setTxAddress().
+*
 * Example: `transceiver.write(0xB54CAB34, buffer, sizeof(buffer));`
 *
 * @param [sendTo] Address to send the payload to
 * @param [data] The data
 * @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
 * @return (none)
+*
+* @see .setTxAddress() .writePayload()
 */
 	void write(uint32_t sendTo, void* data, uint8_t len);
 
+/**
+* @brief Set destination address
+*
+* The library remembers the last address sent to the radio and will skip the SPI transaction if \p sendTo is the same. The remembered address is forgotten when calling .begin() or .resyncConfig(). Power-down mode does not clear the address so it is still remembered after calling .powerDown().
+*
+* Nodes that only ever talk to one address can call this once and then use .writePayload() instead of .write().
+*
+* Example: `transceiver.setTxAddress(0xB54CAB34);`
+*
+* @param [sendTo] Address to send payloads to
+* @return (none)
+*/
+	void setTxAddress(uint32_t sendTo);
+
+/**
+* @brief Write payload data without changing the destination address
+*
+* If \p data is \p NULL and/or \p len is \p 0 then nothing happens.
+*
+* Example: `transceiver.writePayload(buffer, sizeof(buffer));`
+*
+* @param [data] The data
+* @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
+* @return (none)
+*
+* @see .setTxAddress()
+*/
+	void writePayload(void* data, uint8_t len);
+
+/**
+* @brief Load the next payload and address to send ahead of time
+*
+* The TX payload and address registers are separate from the RX payload register and keep their contents while receiving,
+* so a reply can be loaded while waiting for a request and sent with .sendStaged() from the \p onRxComplete event without writing the whole payload after the request arrives.
+* Once the request has arrived its payload can be read at any time, even after the reply has been sent.
+*
+* Example: `transceiver.stagePayload(0xB54CAB34, reply, sizeof(reply));`
+*
+* @param [sendTo] Address to send the payload to
+* @param [data] The data
+* @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
+* @return (none)
+*
+* @see .patchPayload() .sendStaged()
+*/
+	void stagePayload(uint32_t sendTo, void* data, uint8_t len);
+
+/**
+* @brief Overwrite the first few bytes of the payload in the radio
+*
+* Use this to change a header (sequence number, status etc) in a payload loaded with .stagePayload() or .write() once the request it depends on has arrived.
+* The rest of the payload is left as it was.
+*
+* Example: `transceiver.patchPayload(header, 2);`
+*
+* @param [data] The new bytes
+* @param [len] Number of bytes to overwrite, starting from the first byte of the payload (max ::NRF905_MAX_PAYLOAD)
+* @return (none)
+*/
+	void patchPayload(void* data, uint8_t len);
+
+/**
+* @brief Send the payload loaded with .stagePayload()
+*
+* Same as .TX() but only transmits if a payload has been staged since the last transmission.
+*
+* Example: `transceiver.sendStaged(NRF905_NEXTMODE_RX, false);`
+*
+* @param [nextMode] What mode to enter once the transmission is complete, see ::nRF905_nextmode_t
+* @param [collisionAvoid] \p true = check for other transmissions before transmitting (CD pin must be connected), \p false = skip the check and just transmit
+* @return \p false if nothing is staged, or if collision avoidance is enabled and other transmissions are going on, or the duty cycle budget has run out, \p true if transmission has successfully begun
+*/
+	bool sendStaged(nRF905_nextmode_t nextMode, bool collisionAvoid);
+
 /**
 * @brief Read received payload.
 *
@@ -410,6 +752,83 @@ public:
 */
 	void read(void* data, uint8_t len);
 
+/**
+* @brief When the last payload finished arriving
+*
+* This is the micros() time DR went high, recorded at the start of .interrupt_dr() so it's accurate to within the interrupt latency.
+* In polled mode it's the time of the .poll() call that saw DR go high, so it's only as accurate as how often .poll() is called.
+* Call this from the \p onRxComplete event, or use the timestamp from .readPacket() if \p NRF905_RX_BUFFER_SLOTS is enabled.
+* Subtract the packet's airtime (see .airtime(), using the other radio's settings) to get when the packet started being sent.
+*
+* Example: `unsigned long arrivedAt = transceiver.rxTimestamp();`
+*
+* @return micros() time
+*/
+	unsigned long rxTimestamp();
+
+/**
+* @brief When the address of the last incoming packet matched
+*
+* This is the micros() time AM went high, which is when the address has been received and the payload is starting to arrive.
+* Accuracy is the same as .rxTimestamp().
+*
+* Example: `unsigned long matchedAt = transceiver.addrMatchTimestamp();`
+*
+* @return micros() time
+*/
+	unsigned long addrMatchTimestamp();
+
+/**
+* @brief When the last transmission finished
+*
+* This is the micros() time DR went high at the end of a transmission (\p nextMode ::NRF905_NEXTMODE_STANDBY or ::NRF905_NEXTMODE_TX only).
+* Accuracy is the same as .rxTimestamp().
+*
+* Example: `unsigned long sentAt = transceiver.txTimestamp();`
+*
+* @return micros() time
+*/
+	unsigned long txTimestamp();
+
+#if NRF905_RX_BUFFER_SLOTS
+/**
+* @brief Number of payloads waiting in the receive buffer
+*
+* Only available if \p NRF905_RX_BUFFER_SLOTS in nRF905_config.h is not 0. The library reads each payload from the radio before the onRxComplete event runs, so don't call .read() from the event.
+*
+* Example: `while(transceiver.available())`
+*
+* @return Number of buffered payloads
+*/
+	uint8_t available();
+
+/**
+* @brief Take the oldest payload out of the receive buffer
+*
+* Only available if \p NRF905_RX_BUFFER_SLOTS in nRF905_config.h is not 0. This does not access the radio so it's safe to call while the radio is receiving, but it must not be called from more than one place at a time (like from an event function and from loop()).
+*
+* Example: `uint8_t len = transceiver.readPacket(buffer, sizeof(buffer), &arrivedAt);`
+*
+* @param [data] Buffer for the data
+* @param [len] Size of buffer, if the payload is larger than this then the rest of it is thrown away
+* @param [timestamp] If not \p NULL then this is set to the micros() time the payload finished arriving, see .rxTimestamp()
+* @return Number of bytes copied into \p data, or \p 0 if the buffer is empty
+*/
+	uint8_t readPacket(void* data, uint8_t len, unsigned long* timestamp = NULL);
+
+/**
+* @brief Number of payloads thrown away because the receive buffer was full
+*
+* Only available if \p NRF905_RX_BUFFER_SLOTS in nRF905_config.h is not 0.
+* Safe to call from event functions, interrupts are put back to how they were afterwards.
+*
+* Example: `Serial.println(transceiver.rxOverflowCount());`
+*
+* @return Overflow count
+*/
+	uint16_t rxOverflowCount();
+#endif
+
 	//uint32_t readUInt32(); // TODO
 	//uint8_t readUInt8(); // TODO
 	//char readChar(); // TODO
@@ -418,8 +837,8 @@ public:
 /**
 * @brief Begin a transmission
 *
-* If the radio is in power-down mode then this function will take an additional 3ms to complete.\n
-* If 3ms is too long then call .standby() and do whatever you need to do for at least 3ms before calling .TX().
+* If the radio is in power-down mode or was powered up less than 3ms ago then this function will wait for the rest of the 3ms power-up time before starting the transmission.\n
+* If that is too long then call .prepareWake() and do whatever you need to do (like reading sensors) before calling .TX().
 *
 * If \p nextMode is set to ::NRF905_NEXTMODE_RX and the radio was in standby mode then this function will take an additional 700us to complete.\n
 * If 700us is too long then set \p nextMode to ::NRF905_NEXTMODE_STANDBY and call .RX() in the \p onTxComplete event instead.
@@ -432,12 +851,98 @@ public:
 *
 * @param [nextMode] What mode to enter once the transmission is complete, see ::nRF905_nextmode_t
 * @param [collisionAvoid] \p true = check for other transmissions before transmitting (CD pin must be connected), \p false = skip the check and just transmit
-* @return \p false if collision avoidance is enabled and other transmissions are going on, \p true if transmission has successfully begun
+* @return \p false if collision avoidance is enabled and other transmissions are going on, or the duty cycle budget has run out (see .setDutyCycle()), \p true if transmission has successfully begun
 *
 * @see ::nRF905_nextmode_t
 */
 	bool TX(nRF905_nextmode_t nextMode, bool collisionAvoid);
 
+/**
+* @brief Begin a transmission without waiting
+*
+* Same as .TX() but returns straight away instead of waiting the 3ms power-up time or the 700us/14us needed before entering \p nextMode.
+* The rest of the mode changes are done by .service() once enough time has passed, so .service() must be called often (from loop() or a timer interrupt) until it returns \p true.\n
+* If .service() isn't called before the payload has been sent then the radio will transmit a carrier wave (or retransmit the payload if auto-retransmit is enabled) until it is called.
+* In interrupt mode the DR interrupt also calls .service() when a transmission completes.
+*
+* Calling .RX(), .standby() or .powerDown() cancels any mode changes that are still waiting.
+*
+* Example: `transceiver.startTX(NRF905_NEXTMODE_RX, true);`
+*
+* @param [nextMode] What mode to enter once the transmission is complete, see ::nRF905_nextmode_t
+* @param [collisionAvoid] \p true = check for other transmissions before transmitting (CD pin must be connected), \p false = skip the check and just transmit
+* @return \p false if collision avoidance is enabled and other transmissions are going on, the duty cycle budget has run out or the previous .startTX() is still waiting on .service(), \p true if transmission has successfully begun
+*
+* @see .service()
+*/
+	bool startTX(nRF905_nextmode_t nextMode, bool collisionAvoid);
+
+/**
+* @brief Finish off mode changes for a transmission started by .startTX()
+*
+* Example: `transceiver.service();`
+*
+* @return \p true if there is nothing left to do, \p false if still waiting
+*/
+	bool service();
+
+#if NRF905_TX_QUEUE_SLOTS
+/**
+* @brief Add a payload to the transmit queue
+*
+* Only available if \p NRF905_TX_QUEUE_SLOTS in nRF905_config.h is not 0.
+*
+* If the queue is idle then the payload is sent straight away, otherwise it will be sent by .service() once the DR interrupt (or .poll() in polled mode) has seen the payloads before it finish. The radio goes into standby mode between each payload and enters the mode set by .setTxQueueNextMode() once the queue is empty.\n
+* The DR interrupt only marks the next payload as ready, it doesn't send it itself, so .service() must be called often while the queue is busy. It also has to be called soon after each payload starts so the radio goes back into standby mode instead of sending a carrier wave.\n
+* The onTxComplete event still runs after each payload.
+* If the duty cycle budget set by .setDutyCycle() runs out then the queue stops and starts again from the next .enqueue().
+*
+* Don't use .write() or .TX() while the queue is busy and make sure the DR pin is connected or .poll() is called often.
+* IDs count up from 1 and wrap around after 255 back to 0, .txQueueSent() copes with the wrap around as long as the ID is checked within 127 payloads of it being queued.
+*
+* Example: `int16_t id = transceiver.enqueue(0xB54CAB34, buffer, sizeof(buffer));`
+*
+* @param [sendTo] Address to send the payload to
+* @param [data] The data, this is copied into the queue
+* @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
+* @return ID of the queued payload to use with .txQueueSent(), or \p -1 if the queue is full
+*
+* @see .txQueueSent() .setTxQueueNextMode()
+*/
+	int16_t enqueue(uint32_t sendTo, void* data, uint8_t len);
+
+/**
+* @brief Number of payloads in the transmit queue that have not finished sending yet
+*
+* Example: `while(transceiver.txQueueLength()) transceiver.service();`
+*
+* @return Queue length
+*/
+	uint8_t txQueueLength();
+
+/**
+* @brief See if a queued payload has been sent
+*
+* Example: `if(transceiver.txQueueSent(id))`
+*
+* @param [id] ID returned by .enqueue()
+* @return \p true if the payload has been sent, otherwise \p false
+*/
+	bool txQueueSent(uint8_t id);
+
+/**
+* @brief Mode to enter once the transmit queue is empty
+*
+* Only ::NRF905_NEXTMODE_STANDBY (default) and ::NRF905_NEXTMODE_RX are supported.
+*
+* Example: `transceiver.setTxQueueNextMode(NRF905_NEXTMODE_RX);`
+*
+* @param [nextMode] Mode to enter, see ::nRF905_nextmode_t
+* @return (none)
+*/
+	void setTxQueueNextMode(nRF905_nextmode_t nextMode);
+#endif
+
 /**
 * @brief Enter receive mode.
 *
@@ -462,13 +967,143 @@ public:
 */
 	void powerDown();
 
+/**
+* @brief See if a transmission is still going on
+*
+* Only works when the transmission was started with \p nextMode set to ::NRF905_NEXTMODE_STANDBY or ::NRF905_NEXTMODE_TX since it relies on DR going high at the end of the transmission (same as the onTxComplete event).
+* In polled mode .poll() must be called for this to change.
+*
+* Example: `while(transceiver.transmitting()) transceiver.poll();`
+*
+* @return \p true if the radio is still transmitting, otherwise \p false
+*/
+	bool transmitting();
+
+/**
+* @brief Wait for the current transmission to finish
+*
+* Waits until .transmitting() is \p false and the radio has gone into the next mode, calling .poll() in polled mode.
+* The payload can't be changed while it's being sent, so call this before writing the next one.
+*
+* Example: `transceiver.waitTX(NRF905_TX_TIMEOUT);`
+*
+* @param [timeout] Longest time to wait (ms)
+* @return \p true if the transmission finished, \p false if it was still going on when the timeout ran out
+*/
+	bool waitTX(uint16_t timeout);
+
+/**
+* @brief Begin a transmission once the channel is free
+*
+* Same as .TX() with collision avoidance, but if the channel is busy then it waits a random amount of time (up to one TX settle time plus preamble time) and tries again,
+* so that radios waiting for the same transmission to finish don't all start at the same moment. Gives up once the timeout runs out.
+*
+* Example: `if(!transceiver.TXWhenClear(NRF905_NEXTMODE_STANDBY, 50)) Serial.println(F("Channel busy"));`
+*
+* @param [nextMode] What mode to enter once the transmission is complete, see ::nRF905_nextmode_t
+* @param [timeout] Longest time to keep trying (ms)
+* @return \p true if the transmission has begun, \p false if the channel was busy (or the duty cycle budget ran out, see .setDutyCycle()) for the whole timeout
+*/
+	bool TXWhenClear(nRF905_nextmode_t nextMode, uint16_t timeout);
+
+/**
+* @brief Start powering up the radio without waiting
+*
+* If the radio is in power-down mode then it is put into standby mode, otherwise nothing happens.
+* The radio takes 3ms to power-up, use this time to do something else like reading sensors and then call .TX() which will only wait for whatever is left of the 3ms.
+*
+* Example: `transceiver.prepareWake(); readSensors(); transceiver.TX(NRF905_NEXTMODE_STANDBY, false);`
+*
+* @return (none)
+*
+* @see .wakeRemaining()
+*/
+	void prepareWake();
+
+/**
+* @brief How much longer the radio needs to finish powering up
+*
+* Example: `if(!transceiver.wakeRemaining())`
+*
+* @return Microseconds left, \p 0 if the radio is ready
+*/
+	unsigned int wakeRemaining();
+
+/**
+* @brief How long a packet is on air with the current transmit settings
+*
+* Worked out from the transmit address size, transmit payload size and CRC setting, plus the 10 bit preamble. Use ::NRF905_CALC_AIRTIME() for a compile time value.
+*
+* Example: `unsigned int timeout = transceiver.airtime() * 2;`
+*
+* @return Airtime in microseconds
+*/
+	uint16_t airtime();
+
+/**
+* @brief How long a packet is on air with the current receive settings
+*
+* Same as .airtime() but worked out from the receive address size and receive payload size, so it's how long the packets this radio is listening for take to arrive.
+*
+* Example: `unsigned int slotTime = transceiver.rxAirtime() + 1000;`
+*
+* @return Airtime in microseconds
+*/
+	uint16_t rxAirtime();
+
+/**
+* @brief Most packets that can be sent each second with the current transmit settings
+*
+* Includes the time it takes the radio to switch from standby into transmit mode before each packet. Doesn't include the time spent loading the payload over SPI or anything the application does between packets.
+*
+* Example: `Serial.println(transceiver.maxPacketRate());`
+*
+* @return Packets per second
+*/
+	uint16_t maxPacketRate();
+
+/**
+* @brief Most payload bytes that can be sent each second with the current transmit settings
+*
+* Same as .maxPacketRate() multiplied by the transmit payload size.
+*
+* Example: `Serial.println(transceiver.maxGoodput());`
+*
+* @return Bytes per second
+*/
+	uint16_t maxGoodput();
+
+/**
+* @brief Limit how much of the time the radio can spend transmitting
+*
+* Some bands (like 868MHz in Europe) only allow transmitting for a percentage of each hour.
+* Each packet uses up its .airtime() from a budget that starts full with an hour's worth of airtime and fills back up at the duty cycle rate.
+* Once the budget doesn't have enough left for the next packet .TX(), .startTX() and .sendStaged() return \p false until enough has built up again, .dutyCycleWait() says how long that will be.
+* A transmission started with \p nextMode as ::NRF905_NEXTMODE_TX only counts as one packet.
+*
+* Example: `transceiver.setDutyCycle(10); // 1%`
+*
+* @param [perMille] Duty cycle in tenths of a percent (1 = 0.1%, 10 = 1%, 1000 = 100%), \p 0 to disable the limit
+* @return (none)
+*/
+	void setDutyCycle(uint16_t perMille);
+
+/**
+* @brief How long until the duty cycle budget has enough airtime for the next packet
+*
+* Example: `delay(transceiver.dutyCycleWait());`
+*
+* @return Milliseconds to wait, \p 0 if a packet can be sent now or there is no limit
+*/
+	uint32_t dutyCycleWait();
+
 /**
 * @brief Enter standby mode.
 *
 * Radio will wait for any ongoing transmissions to complete before entering standby mode.
 *
 * If the radio was in power-down mode then there must be a 3ms delay between entering standby mode and beginning a transmission using .TX() with \p nextMode as ::NRF905_NEXTMODE_STANDBY or ::NRF905_NEXTMODE_RX otherwise the transmission will not start.
-* Calling .TX() while the radio is in power-down mode will automatically power-up the radio and wait 3ms before starting the transmission.
+* .TX() keeps track of when the radio was powered up and will only wait for whatever is left of the 3ms.
 *
 * Example: `transceiver.standby();`
 *
@@ -490,6 +1125,8 @@ public:
 /**
 * @brief Read configuration registers into byte array of ::NRF905_REGISTER_COUNT elements, mainly for debugging.
 *
+* The library keeps its own copy of the configuration registers so that the setter methods don't have to read them from the radio first, this method also refreshes that copy.
+*
 * Example: `transceiver.getConfigRegisters(regs);`
 *
 * @param [regs] Buffer for register data, size must be at least ::NRF905_REGISTER_COUNT bytes.
@@ -497,6 +1134,76 @@ public:
 */
 	void getConfigRegisters(void* regs);
 
+/**
+* @brief Write the library's copy of the configuration registers back to the radio
+*
+* Use this if the radio has lost its configuration without the library knowing about it, like if its power supply was cut or it was reset by something else.
+*
+* Example: `transceiver.resyncConfig();`
+*
+* @return (none)
+*/
+	void resyncConfig();
+
+/**
+* @brief Start a batch of configuration changes
+*
+* After calling this method the config setters (.setChannel(), .setBand(), .setTransmitPower(), .setCRC(), .setPayloadSize() etc) only update the library's copy of the registers, nothing is sent to the radio until .commitConfig() is called.
+* This is much faster than calling each setter on its own since only 1 SPI transaction is needed instead of 1 for each setter.
+* .scanChannels() and .quietestChannel() need to retune the radio, so they send any waiting changes first.
+*
+* Example:\n
+* `transceiver.beginConfig();`\n
+* `transceiver.setChannel(100);`\n
+* `transceiver.setTransmitPower(NRF905_PWR_6);`\n
+* `transceiver.setPayloadSize(8, 8);`\n
+* `transceiver.commitConfig();`
+*
+* @return (none)
+*
+* @see .commitConfig()
+*/
+	void beginConfig();
+
+/**
+* @brief Send all configuration changes made since .beginConfig() to the radio
+*
+* The smallest range of registers that covers all of the changes is written in a single SPI transaction.
+*
+* Example: `transceiver.commitConfig();`
+*
+* @return (none)
+*
+* @see .beginConfig()
+*/
+	void commitConfig();
+
+#if NRF905_STATS
+/**
+* @brief Get a copy of the statistics
+*
+* Only available if \p NRF905_STATS in nRF905_config.h is enabled.
+* Safe to call from event functions, interrupts are put back to how they were afterwards.
+*
+* Example: `nRF905_stats_t stats; transceiver.getStats(&stats);`
+*
+* @param [stats] Where to copy the statistics to
+* @return (none)
+*
+* @see ::nRF905_stats_t
+*/
+	void getStats(nRF905_stats_t* stats);
+
+/**
+* @brief Set all statistics back to 0
+*
+* Example: `transceiver.resetStats();`
+*
+* @return (none)
+*/
+	void resetStats();
+#endif
+
 /**
 * @brief When running in interrupt mode this method must be called from the DR interrupt callback function.
 *
@@ -525,6 +1232,42 @@ public:
 * @return (none)
 */
 	void poll();
+
+/**
+* @brief See if the radio is running in polled mode
+*
+* The radio is in polled mode when it was set up with no DR interrupt function, classes built on top of nRF905 use this to decide whether they need to call .poll() themselves.
+*
+* Example: `if(transceiver.polled()) transceiver.poll();`
+*
+* @return \p true if in polled mode, otherwise \p false
+*/
+	bool polled();
+
+/**
+* @brief Read the status register
+*
+* Bit \p NRF905_STATUS_DR is the DR state and bit \p NRF905_STATUS_AM is the AM state (see nRF905_defs.h).
+*
+* Example: `uint8_t status = transceiver.readStatus();`
+*
+* @return Status register
+*/
+	uint8_t readStatus();
+
+/**
+* @brief Run one polled mode step with a status register value that has already been read
+*
+* .poll() is .readStatus() followed by this. Splitting them up lets nRF905Group read the status of all of its radios before running any events.
+* Does nothing if not in polled mode.
+*
+* Example: `transceiver.pollState(status, statusTime);`
+*
+* @param [state] Status register value from .readStatus()
+* @param [now] micros() time the status register was read at, used for the receive and address match timestamps
+* @return (none)
+*/
+	void pollState(uint8_t state, unsigned long now);
 };
 
 #endif /* NRF905_H_ */
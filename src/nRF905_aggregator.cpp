@@ -0,0 +1,191 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_aggregator.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+nRF905Aggregator::nRF905Aggregator()
+{
+	radio = NULL;
+	sendTo = 0;
+	flushTime = 0;
+	txLen = 0;
+	txFirstAdded = 0;
+	rxAfterTx = false;
+	rxFrameReady = false;
+	rxDropped = 0;
+	unpackPos = NRF905_MAX_PAYLOAD;
+}
+
+void nRF905Aggregator::begin(nRF905& radio, uint32_t sendTo, uint16_t flushTime)
+{
+	this->radio = &radio;
+	this->sendTo = sendTo;
+	this->flushTime = flushTime;
+
+	radio.setPayloadSize(NRF905_MAX_PAYLOAD, NRF905_MAX_PAYLOAD);
+	radio.RX();
+}
+
+bool nRF905Aggregator::add(void* data, uint8_t len)
+{
+	if(radio == NULL || len < 1 || len > NRF905_AGGREGATOR_MAX_RECORD)
+		return false;
+
+	// The current payload stays put if the channel is too busy to send it
+	if(txLen + 1 + len > NRF905_MAX_PAYLOAD && !flush())
+		return false;
+
+	if(!txLen)
+		txFirstAdded = millis();
+
+	txFrame[txLen++] = len;
+	memcpy(&txFrame[txLen], data, len);
+	txLen += len;
+
+	if(txLen >= NRF905_MAX_PAYLOAD)
+		flush();
+
+	return true;
+}
+
+bool nRF905Aggregator::flush()
+{
+	if(radio == NULL || !txLen)
+		return true;
+
+	// Mark the end of the records, otherwise the receiver would see whatever was left in the payload from last time
+	// This goes after txLen so that more records can still be added if the payload can't be sent
+	uint8_t len = txLen;
+	if(len < NRF905_MAX_PAYLOAD)
+		txFrame[len++] = 0;
+
+	// The payload can't be changed while the previous one is on air
+	radio->waitTX(NRF905_TX_TIMEOUT);
+
+	radio->write(sendTo, txFrame, len);
+
+	// Standby so that DR goes high once the payload has been sent, service() will then go back to RX
+	if(!radio->TXWhenClear(NRF905_NEXTMODE_STANDBY, NRF905_CLEAR_TIMEOUT))
+		return false;
+	rxAfterTx = true;
+
+	txLen = 0;
+	return true;
+}
+
+void nRF905Aggregator::service()
+{
+	if(radio == NULL)
+		return;
+
+	if(radio->polled())
+		radio->poll();
+
+	if(txLen && (unsigned long)(millis() - txFirstAdded) >= flushTime)
+		flush();
+
+	if(rxAfterTx && !radio->transmitting())
+	{
+		rxAfterTx = false;
+		radio->RX();
+	}
+}
+
+void nRF905Aggregator::receive()
+{
+	if(radio == NULL)
+		return;
+
+#if NRF905_RX_BUFFER_SLOTS
+	// Payloads wait in the radio's receive buffer until the records in the previous one have been read
+	if(rxFrameReady)
+		return;
+
+	uint8_t len = radio->readPacket(rxFrame, sizeof(rxFrame));
+	if(!len)
+		return;
+	if(len < sizeof(rxFrame))
+		rxFrame[len] = 0;
+#else
+	if(rxFrameReady)
+	{
+		rxDropped++;
+		return;
+	}
+
+	radio->read(rxFrame, sizeof(rxFrame));
+#endif
+
+	// Make sure the payload is in the buffer before read() can see it
+	NRF905_MEMORY_BARRIER();
+	rxFrameReady = true;
+}
+
+// Move on to the next received payload
+bool nRF905Aggregator::nextFrame()
+{
+#if NRF905_RX_BUFFER_SLOTS
+	receive();
+#endif
+
+	if(!rxFrameReady)
+		return false;
+
+	memcpy(unpackFrame, rxFrame, sizeof(unpackFrame));
+	unpackPos = 0;
+
+	// Make sure the payload has been copied before receive() can overwrite it
+	NRF905_MEMORY_BARRIER();
+	rxFrameReady = false;
+
+	return true;
+}
+
+uint8_t nRF905Aggregator::read(void* data, uint8_t len)
+{
+	if(radio == NULL)
+		return 0;
+
+	while(1)
+	{
+		// Length byte of 0 or the end of the payload means there are no more records
+		if(unpackPos < NRF905_MAX_PAYLOAD && unpackFrame[unpackPos] != 0)
+		{
+			uint8_t recordLen = unpackFrame[unpackPos];
+			if(recordLen > NRF905_MAX_PAYLOAD - 1 - unpackPos)
+			{
+				// Goes past the end of the payload, must be corrupt
+				unpackPos = NRF905_MAX_PAYLOAD;
+				continue;
+			}
+
+			if(len > recordLen)
+				len = recordLen;
+			memcpy(data, &unpackFrame[unpackPos + 1], len);
+
+			unpackPos += 1 + recordLen;
+			return len;
+		}
+
+		if(!nextFrame())
+			return 0;
+	}
+}
+
+uint16_t nRF905Aggregator::droppedFrames()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	uint16_t count = rxDropped;
+	nRF905_irqRestore(irq);
+	return count;
+}
@@ -0,0 +1,134 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_AGGREGATOR_H_
+#define NRF905_AGGREGATOR_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+#define NRF905_AGGREGATOR_MAX_RECORD	(NRF905_MAX_PAYLOAD - 1) ///< Maximum record length
+
+/**
+* @brief Pack small records into as few payloads as possible
+*
+* Each record is stored in the payload as a length byte followed by the data, a length of 0 marks the end of the records.
+* A payload is sent once the next record won't fit or when the flush time has passed since the first record was added, whichever comes first.
+*
+* In interrupt mode call .receive() from the \p onRxComplete event, in polled mode call it after .poll() has run the event.
+* If \p NRF905_RX_BUFFER_SLOTS is enabled then .read() does this automatically instead.
+* .service() must be called often to send payloads once the flush time has passed.
+*/
+class nRF905Aggregator
+{
+private:
+	nRF905* radio;
+	uint32_t sendTo;
+	uint16_t flushTime;
+
+	uint8_t txFrame[NRF905_MAX_PAYLOAD];
+	uint8_t txLen;
+	unsigned long txFirstAdded;
+	bool rxAfterTx;
+
+	uint8_t rxFrame[NRF905_MAX_PAYLOAD];
+	volatile bool rxFrameReady;
+	uint16_t rxDropped;
+
+	uint8_t unpackFrame[NRF905_MAX_PAYLOAD];
+	uint8_t unpackPos;
+
+	bool nextFrame();
+
+public:
+	nRF905Aggregator();
+
+/**
+* @brief Attach to a radio
+*
+* The radio should have already been set up with .begin(). Its payload size is set to ::NRF905_MAX_PAYLOAD and it is put into receive mode.
+*
+* Example: `aggregator.begin(transceiver, 0xB54CAB34, 5);`
+*
+* @param [radio] The radio
+* @param [sendTo] Address to send payloads to
+* @param [flushTime] Longest time a record can wait before being sent (ms)
+* @return (none)
+*/
+	void begin(nRF905& radio, uint32_t sendTo, uint16_t flushTime);
+
+/**
+* @brief Add a record to the payload being built
+*
+* If the record doesn't fit in the current payload then the current payload is sent first.
+* If the channel stays busy for longer than \p NRF905_CLEAR_TIMEOUT then the current payload is kept and the record isn't added.
+*
+* Example: `aggregator.add(&reading, sizeof(reading));`
+*
+* @param [data] The record
+* @param [len] Record length (1 - ::NRF905_AGGREGATOR_MAX_RECORD)
+* @return \p false if the record is too big or there wasn't room for it, otherwise \p true
+*/
+	bool add(void* data, uint8_t len);
+
+/**
+* @brief Send the payload being built now instead of waiting
+*
+* Example: `aggregator.flush();`
+*
+* @return \p false if the channel stayed busy for longer than \p NRF905_CLEAR_TIMEOUT and the payload is still waiting to be sent, otherwise \p true
+*/
+	bool flush();
+
+/**
+* @brief Send the payload once the flush time has passed and go back into receive mode once it has been sent
+*
+* Call this as often as possible.
+*
+* Example: `aggregator.service();`
+*
+* @return (none)
+*/
+	void service();
+
+/**
+* @brief Read the received payload from the radio
+*
+* Call this from the \p onRxComplete event. If the previous payload hasn't been picked up by .read() yet then the new payload is thrown away.
+* Don't call this if \p NRF905_RX_BUFFER_SLOTS is enabled, .read() takes payloads from the radio's receive buffer itself.
+*
+* Example: `aggregator.receive();`
+*
+* @return (none)
+*/
+	void receive();
+
+/**
+* @brief Get the next received record
+*
+* Example: `uint8_t len = aggregator.read(buffer, sizeof(buffer));`
+*
+* @param [data] Buffer to copy the record into
+* @param [len] Buffer size, the record is cut short if it is bigger than this
+* @return Record length, \p 0 if there are no records
+*/
+	uint8_t read(void* data, uint8_t len);
+
+/**
+* @brief Number of received payloads that were thrown away because the records in the previous payload hadn't been read yet
+*
+* Example: `Serial.println(aggregator.droppedFrames());`
+*
+* @return Dropped payload count
+*/
+	uint16_t droppedFrames();
+};
+
+#endif /* NRF905_AGGREGATOR_H_ */
@@ -17,6 +17,65 @@
 // NRF905_CLK_20MHZ
 #define NRF905_CLK_FREQ		NRF905_CLK_16MHZ
 
+// Use the SPI library's block transfer methods (SPI.transfer(buffer, size) or SPI.writeBytes() on ESP) for payloads, addresses and registers
+// This is faster than transferring 1 byte at a time, but some cores might not support it
+// 0 = Transfer 1 byte at a time
+// 1 = Use block transfers
+#define NRF905_SPI_BLOCK_TRANSFER	1
+
+// Use direct port register access for the SS, CE, TXE, PWR, CD and AM pins instead of digitalWrite() and digitalRead()
+// digitalWrite() takes a few microseconds on AVR which slows down chip select and starting transmissions
+// The port register and bit mask of each pin are looked up once in begin(), each write then saves SREG, disables interrupts, does a read-modify-write of
+// the port register and restores SREG (around 1us at 16MHz), this isn't a single SBI/CBI instruction since the pins aren't known at compile time
+// See the pin operations in examples/benchmark to compare before turning it on
+// Only supported on AVR, off by default so that every board gets the same digitalWrite() and digitalRead() behaviour unless this is changed
+// 0 = Use digitalWrite() and digitalRead()
+// 1 = Use direct port access
+#define NRF905_FAST_GPIO	0
+
+// Receive buffer
+// Number of received payloads the library can hold on to (must be a power of 2, max 128)
+// When enabled the library reads each new payload from the radio as soon as it arrives (in the DR interrupt or .poll()) so another payload can be received
+// while the application is busy. Use .available() and .readPacket() to get them. Each slot uses NRF905_MAX_PAYLOAD + 5 bytes of RAM
+// (length, payload and arrival timestamp, 37 bytes on AVR, 32 bit MCUs pad it out to 40 bytes).
+// 0 = Disabled, the application must read the payload itself with .read()
+#define NRF905_RX_BUFFER_SLOTS	0
+
+// Transmit queue
+// Number of payloads that can be queued up with .enqueue() (must be a power of 2, max 128)
+// Queued payloads are sent back-to-back, the DR interrupt (or .poll()) marks the next one as ready as soon as the previous one has finished and .service() sends it.
+// Each slot uses NRF905_MAX_PAYLOAD + 5 bytes of RAM.
+// 0 = Disabled
+#define NRF905_TX_QUEUE_SLOTS	0
+
+// Statistics
+// Count events, SPI traffic and time spent in interrupts and event functions, see .getStats()
+// Uses around 64 bytes of RAM per radio and adds a few micros() calls to each interrupt
+// 0 = Disabled
+// 1 = Enabled
+#define NRF905_STATS	0
+
+// Maximum number of radios that can be added to an nRF905Group
+#define NRF905_GROUP_MAX_RADIOS	4
+
+// How long nRF905Stream, nRF905Link and nRF905Aggregator keep trying to send a payload while the channel is busy before giving up on it (ms)
+#define NRF905_CLEAR_TIMEOUT	50
+
+// nRF905Stream receive buffer size in bytes (must be a power of 2, max 128)
+#define NRF905_STREAM_BUFFER_SIZE	64
+
+// nRF905Link send and receive window size in frames (1, 2, 4 or 8)
+// Each frame in the window uses 2 * NRF905_MAX_PAYLOAD bytes of RAM
+#define NRF905_LINK_WINDOW	4
+
+// Number of channels in an nRF905Hop hop table (2 - 255)
+// Each channel uses 2 bytes of RAM
+#define NRF905_HOP_CHANNELS	16
+
+// Number of slot assignments an nRF905Tdma base station can hold (1 - 255)
+// Each assignment uses 4 bytes of RAM
+#define NRF905_TDMA_ASSIGNMENTS	16
+
 
 ///////////////////
 // Default radio settings
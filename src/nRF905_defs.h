@@ -62,6 +62,92 @@
 #define NRF905_STATUS_DR		5
 #define NRF905_STATUS_AM		7
 
+// Stop the compiler from moving memory accesses across this point
+#define NRF905_MEMORY_BARRIER()	__asm__ __volatile__ ("" ::: "memory")
+
+// Disable interrupts and then put them back to how they were, unlike noInterrupts() and interrupts() this is safe to use inside interrupt handlers
+#if defined(__AVR__)
+typedef uint8_t nRF905_irqstate_t;
+
+static inline nRF905_irqstate_t nRF905_irqSave()
+{
+	uint8_t sreg = SREG;
+	cli();
+	return sreg;
+}
+
+static inline void nRF905_irqRestore(nRF905_irqstate_t state)
+{
+	SREG = state;
+}
+#elif defined(__arm__) && defined(__CORTEX_M)
+typedef uint32_t nRF905_irqstate_t;
+
+static inline nRF905_irqstate_t nRF905_irqSave()
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	return primask;
+}
+
+static inline void nRF905_irqRestore(nRF905_irqstate_t state)
+{
+	__set_PRIMASK(state);
+}
+#else
+// No portable way of reading the interrupt state, assume they were enabled
+typedef uint8_t nRF905_irqstate_t;
+
+static inline nRF905_irqstate_t nRF905_irqSave()
+{
+	noInterrupts();
+	return 1;
+}
+
+static inline void nRF905_irqRestore(nRF905_irqstate_t state)
+{
+	if(state)
+		interrupts();
+}
+#endif
+
+// Little endian values in payloads
+static inline void nRF905_put16(uint8_t* buff, uint16_t val)
+{
+	buff[0] = val;
+	buff[1] = val>>8;
+}
+
+static inline uint16_t nRF905_get16(uint8_t* buff)
+{
+	return buff[0] | ((uint16_t)buff[1]<<8);
+}
+
+static inline void nRF905_put32(uint8_t* buff, uint32_t val)
+{
+	nRF905_put16(&buff[0], val);
+	nRF905_put16(&buff[2], val>>16);
+}
+
+static inline uint32_t nRF905_get32(uint8_t* buff)
+{
+	return nRF905_get16(&buff[0]) | ((uint32_t)nRF905_get16(&buff[2])<<16);
+}
+
+// Timings (microseconds)
+#define NRF905_POWERUP_TIME		3000 // Power-down to standby
+#define NRF905_TX_SETTLE_TIME	650 // Standby to transmitting
+#define NRF905_RX_SETTLE_TIME	650 // Standby to receiving
+
+// Supply current (microamps, typical values from the datasheet)
+#define NRF905_CURRENT_POWERDOWN	2.5
+#define NRF905_CURRENT_STANDBY		32
+#define NRF905_CURRENT_RX			12500
+#define NRF905_CURRENT_TX_n10		9000
+#define NRF905_CURRENT_TX_n2		14000
+#define NRF905_CURRENT_TX_6			20000
+#define NRF905_CURRENT_TX_10		30000
+
 /**
 * @brief Save a few mA by reducing receive sensitivity.
 */
@@ -0,0 +1,65 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_group.h"
+#include "nRF905_config.h"
+
+nRF905Group::nRF905Group()
+{
+	count = 0;
+	first = 0;
+}
+
+bool nRF905Group::add(nRF905& radio)
+{
+	if(count >= NRF905_GROUP_MAX_RADIOS)
+		return false;
+
+	radios[count++] = &radio;
+	return true;
+}
+
+uint8_t nRF905Group::size()
+{
+	return count;
+}
+
+void nRF905Group::poll()
+{
+	if(!count)
+		return;
+
+	// Read all status registers first, timestamping each one as it's read
+	uint8_t states[NRF905_GROUP_MAX_RADIOS];
+	unsigned long times[NRF905_GROUP_MAX_RADIOS];
+	for(uint8_t i=0;i<count;i++)
+	{
+		if(radios[i]->polled())
+		{
+			times[i] = micros();
+			states[i] = radios[i]->readStatus();
+		}
+	}
+
+	// Then run events, starting with a different radio each time
+	uint8_t idx = first;
+	for(uint8_t i=0;i<count;i++)
+	{
+		if(radios[idx]->polled())
+			radios[idx]->pollState(states[idx], times[idx]);
+
+		if(++idx >= count)
+			idx = 0;
+	}
+
+	if(++first >= count)
+		first = 0;
+}
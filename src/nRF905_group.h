@@ -0,0 +1,65 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_GROUP_H_
+#define NRF905_GROUP_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+/**
+* @brief Service multiple radios sharing the same SPI bus
+*
+* Radios running in polled mode have their status registers read one after the other before any events are run, so a slow event function for one radio doesn't delay seeing what the other radios are doing. The radio that gets its events run first is rotated on each .poll() call so no radio is always last in line.
+*
+* Radios running in interrupt mode can also be added, they are skipped by .poll() since their interrupts already take care of them.
+*/
+class nRF905Group
+{
+private:
+	nRF905* radios[NRF905_GROUP_MAX_RADIOS];
+	uint8_t count;
+	uint8_t first;
+
+public:
+	nRF905Group();
+
+/**
+* @brief Add a radio to the group
+*
+* The radio should have already been set up with .begin().
+*
+* Example: `group.add(transceiver433);`
+*
+* @param [radio] The radio
+* @return \p false if the group is full (see \p NRF905_GROUP_MAX_RADIOS in nRF905_config.h), otherwise \p true
+*/
+	bool add(nRF905& radio);
+
+/**
+* @brief Number of radios in the group
+*
+* @return Radio count
+*/
+	uint8_t size();
+
+/**
+* @brief Poll all radios in the group that are running in polled mode
+*
+* This should be called as often as possible, same as nRF905.poll().
+*
+* Example: `group.poll();`
+*
+* @return (none)
+*/
+	void poll();
+};
+
+#endif /* NRF905_GROUP_H_ */
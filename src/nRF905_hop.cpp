@@ -0,0 +1,137 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_hop.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+#if NRF905_HOP_CHANNELS < 2 || NRF905_HOP_CHANNELS > 255
+	#error "NRF905_HOP_CHANNELS must be between 2 and 255"
+#endif
+
+nRF905Hop::nRF905Hop()
+{
+	radio = NULL;
+	memset(table, 0, sizeof(table));
+	index = 0;
+	dwellTime = 0;
+	epoch = 0;
+	tunedSlot = 0;
+}
+
+void nRF905Hop::begin(nRF905& radio, nRF905_band_t band, uint32_t freqLow, uint32_t freqHigh, uint32_t seed, uint16_t dwellTime)
+{
+	this->radio = &radio;
+	this->dwellTime = dwellTime;
+
+	if(freqHigh < freqLow)
+		freqHigh = freqLow;
+
+	// Spread the channels evenly across the range
+	uint32_t step = (freqHigh - freqLow) / (NRF905_HOP_CHANNELS - 1);
+	for(uint8_t i=0;i<NRF905_HOP_CHANNELS;i++)
+	{
+		uint16_t channel = NRF905_CALC_CHANNEL(freqLow + (step * i), band);
+		if(channel > 511)
+			channel = 511;
+		table[i] = channel | (band<<8);
+	}
+
+	// Shuffle (Fisher-Yates), xorshift32 so that every radio gets the same order from the same seed
+	uint32_t rng = seed ? seed : 1;
+	for(uint8_t i=NRF905_HOP_CHANNELS-1;i>0;i--)
+	{
+		rng ^= rng<<13;
+		rng ^= rng>>17;
+		rng ^= rng<<5;
+
+		uint8_t j = rng % (i + 1);
+		uint16_t tmp = table[i];
+		table[i] = table[j];
+		table[j] = tmp;
+	}
+
+	epoch = millis();
+	tunedSlot = 0;
+	index = 0;
+	radio.tune(table[0]);
+}
+
+uint32_t nRF905Hop::time()
+{
+	return millis() - epoch;
+}
+
+uint32_t nRF905Hop::slot()
+{
+	if(!dwellTime)
+		return 0;
+	return time() / dwellTime;
+}
+
+void nRF905Hop::sync(uint32_t time)
+{
+	epoch = millis() - time;
+}
+
+bool nRF905Hop::retune(uint8_t index)
+{
+	// Changing channel would ruin the packet that's on air
+	if(!radio->service() || radio->transmitting())
+		return false;
+
+	nRF905_mode_t mode = radio->mode();
+	if(mode == NRF905_MODE_TX || (mode == NRF905_MODE_RX && radio->receiveBusy()))
+		return false;
+
+	this->index = index;
+
+	if(mode == NRF905_MODE_RX)
+	{
+		// Go through standby so the synthesiser locks onto the new frequency
+		radio->standby();
+		radio->tune(table[index]);
+		radio->RX();
+	}
+	else
+		radio->tune(table[index]);
+
+	return true;
+}
+
+bool nRF905Hop::service()
+{
+	if(radio == NULL || !dwellTime)
+		return false;
+
+	if(radio->polled())
+		radio->poll();
+
+	uint32_t slot = this->slot();
+	if(slot == tunedSlot || !retune(slot % NRF905_HOP_CHANNELS))
+		return false;
+
+	tunedSlot = slot;
+	return true;
+}
+
+bool nRF905Hop::next()
+{
+	if(radio == NULL)
+		return false;
+
+	return retune((index + 1) % NRF905_HOP_CHANNELS);
+}
+
+uint16_t nRF905Hop::channel()
+{
+	return table[index] & 0x1FF;
+}
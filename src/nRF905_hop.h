@@ -0,0 +1,122 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_HOP_H_
+#define NRF905_HOP_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+/**
+* @brief Frequency hopping
+*
+* \p NRF905_HOP_CHANNELS channels are spread evenly across a frequency range and shuffled into a hop table using a seed.
+* Radios given the same range and seed get the same table.
+*
+* Time is split into slots of the dwell time, the slot number picks the channel from the table. Radios hop together once their hop clocks are lined up with .sync(),
+* for example one radio can put its .time() in its payloads and the other end calls .sync() when it receives one.
+* Alternatively set the dwell time to 0 and call .next() to hop after each packet instead.
+*
+* Retuning is done with the 2 byte CHAN_CONFIG command and the hop table holds the ready-to-send channel and band bits so nothing needs to be worked out when hopping.
+* Hops are put off while a packet is being sent or received.
+*/
+class nRF905Hop
+{
+private:
+	nRF905* radio;
+	uint16_t table[NRF905_HOP_CHANNELS]; // Bits 0 - 8 channel, bit 9 band
+	uint8_t index;
+	uint16_t dwellTime;
+	unsigned long epoch;
+	uint32_t tunedSlot;
+
+	bool retune(uint8_t index);
+
+public:
+	nRF905Hop();
+
+/**
+* @brief Build the hop table and tune to the first channel
+*
+* Frequencies are converted to channels with ::NRF905_CALC_CHANNEL().
+*
+* Example: `hop.begin(transceiver, NRF905_BAND_433, 433100000, 434700000, 0x1234, 100);`
+*
+* @param [radio] The radio
+* @param [band] Frequency band, see ::nRF905_band_t
+* @param [freqLow] Lowest frequency to use (Hz)
+* @param [freqHigh] Highest frequency to use (Hz)
+* @param [seed] Hop table seed, must be the same for all radios that hop together
+* @param [dwellTime] How long to stay on each channel (ms), \p 0 to only hop when .next() is called
+* @return (none)
+*/
+	void begin(nRF905& radio, nRF905_band_t band, uint32_t freqLow, uint32_t freqHigh, uint32_t seed, uint16_t dwellTime);
+
+/**
+* @brief Hop clock
+*
+* Example: `packet.hopTime = hop.time();`
+*
+* @return Milliseconds since the start of slot 0
+*/
+	uint32_t time();
+
+/**
+* @brief Current slot number
+*
+* Example: `uint32_t slot = hop.slot();`
+*
+* @return Number of dwell times since the start of slot 0
+*/
+	uint32_t slot();
+
+/**
+* @brief Line up the hop clock with another radio
+*
+* Any delay between the other radio reading its .time() and this being called puts the clocks out by that much, adding the packet's airtime (see nRF905::airtime()) helps.
+*
+* Example: `hop.sync(packet.hopTime + (transceiver.airtime() / 1000));`
+*
+* @param [time] The other radio's .time()
+* @return (none)
+*/
+	void sync(uint32_t time);
+
+/**
+* @brief Hop to the next channel once the slot changes
+*
+* Call this as often as possible.
+*
+* Example: `hop.service();`
+*
+* @return \p true if the radio has just hopped, otherwise \p false
+*/
+	bool service();
+
+/**
+* @brief Hop to the next channel in the table now
+*
+* Example: `hop.next();`
+*
+* @return \p false if a packet is being sent or received, otherwise \p true
+*/
+	bool next();
+
+/**
+* @brief Channel the radio is tuned to
+*
+* Example: `Serial.println(hop.channel());`
+*
+* @return Channel (0 - 511)
+*/
+	uint16_t channel();
+};
+
+#endif /* NRF905_HOP_H_ */
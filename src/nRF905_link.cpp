@@ -0,0 +1,412 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_link.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+#if NRF905_LINK_WINDOW < 1 || NRF905_LINK_WINDOW > 8 || (NRF905_LINK_WINDOW & (NRF905_LINK_WINDOW - 1))
+	#error "NRF905_LINK_WINDOW must be 1, 2, 4 or 8"
+#endif
+
+// Frame types
+// DATA: TTPLLLLL SSSSSSSS data..., T = type, P = poll (reply with ACK), L = data length, S = sequence number
+// ACK:  TT000000 AAAAAAAA BBBBBBBB, A = next sequence number expected, B = bitmask of frames received after A (bit 0 = A + 1)
+#define FRAME_TYPE_MASK		0xC0
+#define FRAME_DATA			0x00
+#define FRAME_ACK			0x40
+#define FRAME_POLL			0x20
+#define FRAME_LEN_MASK		0x1F
+
+// Slot flags
+#define SLOT_USED			0x01 // Send window: waiting to be acknowledged, receive window: received and waiting to be read
+#define SLOT_SENT			0x02 // Has been sent and is waiting for an acknowledgement
+#define SLOT_RESEND			0x04 // Has been sent before
+
+// Retransmission timeout limits (us)
+#define RTO_INITIAL			50000
+#define RTO_MIN				5000
+#define RTO_MAX				1000000
+
+// Smallest gap between the smoothed round trip time and the timeout (us), same job as the clock granularity G in RFC 6298
+// The receiver can be late sending an acknowledgement by the random wait in TXWhenClear() plus however long it takes to get around to calling service()
+#define RTO_GRANULARITY		2000
+
+#define SLOT(slots, seq)	(&slots[(seq) & (NRF905_LINK_WINDOW - 1)])
+
+nRF905Link::nRF905Link()
+{
+	radio = NULL;
+	sendTo = 0;
+	window = NRF905_LINK_WINDOW;
+	memset(txSlots, 0, sizeof(txSlots));
+	memset(rxSlots, 0, sizeof(rxSlots));
+	txBase = 0;
+	txNext = 0;
+	waitingAck = false;
+	pollResent = false;
+	pollSentAt = 0;
+	rto = RTO_INITIAL;
+	srtt = 0;
+	rttvar = 0;
+	rxBase = 0;
+	ackPending = false;
+	rxFrameReady = false;
+	memset(&stats, 0, sizeof(nRF905_link_stats_t));
+}
+
+void nRF905Link::begin(nRF905& radio, uint32_t sendTo)
+{
+	this->radio = &radio;
+	this->sendTo = sendTo;
+
+	radio.setPayloadSize(NRF905_MAX_PAYLOAD, NRF905_MAX_PAYLOAD);
+	radio.RX();
+}
+
+void nRF905Link::setWindow(uint8_t window)
+{
+	if(window < 1)
+		window = 1;
+	else if(window > NRF905_LINK_WINDOW)
+		window = NRF905_LINK_WINDOW;
+	this->window = window;
+}
+
+bool nRF905Link::send(void* data, uint8_t len)
+{
+	if((uint8_t)(txNext - txBase) >= window)
+		return false;
+
+	if(len > NRF905_LINK_MAX_DATA)
+		len = NRF905_LINK_MAX_DATA;
+
+	slot_t* slot = SLOT(txSlots, txNext);
+	slot->len = len;
+	slot->flags = SLOT_USED;
+	memcpy(slot->data, data, len);
+	txNext++;
+
+	return true;
+}
+
+uint8_t nRF905Link::pending()
+{
+	return txNext - txBase;
+}
+
+uint8_t nRF905Link::read(void* data, uint8_t len)
+{
+	slot_t* slot = SLOT(rxSlots, rxBase);
+	if(!(slot->flags & SLOT_USED))
+		return 0;
+
+	if(len > slot->len)
+		len = slot->len;
+	memcpy(data, slot->data, len);
+
+	// Move the window along before freeing the slot, otherwise receive() could put an old frame in it
+	rxBase++;
+	NRF905_MEMORY_BARRIER();
+	slot->flags = 0;
+
+	return len;
+}
+
+void nRF905Link::receive()
+{
+	if(radio == NULL)
+		return;
+
+	uint8_t frame[NRF905_MAX_PAYLOAD];
+	radio->read(frame, sizeof(frame));
+
+	// Data frames go straight into the receive window, anything else is left for service()
+	if((frame[0] & FRAME_TYPE_MASK) == FRAME_DATA)
+		processData(frame, sizeof(frame));
+	else if(!rxFrameReady)
+	{
+		memcpy(rxFrame, frame, sizeof(rxFrame));
+
+		// Make sure the frame is in the buffer before service() can see it
+		NRF905_MEMORY_BARRIER();
+		rxFrameReady = true;
+	}
+}
+
+bool nRF905Link::transmit(uint8_t* frame, uint8_t len, nRF905_nextmode_t nextMode)
+{
+	// The payload can't be changed while the previous frame is on air
+	radio->waitTX(NRF905_TX_TIMEOUT);
+	radio->write(sendTo, frame, len);
+	return radio->TXWhenClear(nextMode, NRF905_CLEAR_TIMEOUT);
+}
+
+void nRF905Link::sendBurst()
+{
+	// Find the last frame that needs sending so it can ask for an acknowledgement
+	uint8_t count = 0;
+	uint8_t last = 0;
+	for(uint8_t seq = txBase; seq != txNext; seq++)
+	{
+		slot_t* slot = SLOT(txSlots, seq);
+		if((slot->flags & (SLOT_USED | SLOT_SENT)) == SLOT_USED)
+		{
+			last = seq;
+			count++;
+		}
+	}
+
+	if(!count)
+		return;
+
+	pollResent = false;
+
+	uint8_t frame[NRF905_MAX_PAYLOAD];
+	for(uint8_t seq = txBase; count; seq++)
+	{
+		slot_t* slot = SLOT(txSlots, seq);
+		if((slot->flags & (SLOT_USED | SLOT_SENT)) != SLOT_USED)
+			continue;
+
+		frame[0] = FRAME_DATA | slot->len | ((seq == last) ? FRAME_POLL : 0);
+		frame[1] = seq;
+		memcpy(&frame[2], slot->data, slot->len);
+
+		// Standby so that DR goes high once the frame has been sent
+		// If the channel stays busy then leave the rest of the frames for the next burst
+		if(!transmit(frame, slot->len + 2, NRF905_NEXTMODE_STANDBY))
+			break;
+
+		if(slot->flags & SLOT_RESEND)
+		{
+			stats.dataResent++;
+			if(seq == last)
+				pollResent = true;
+		}
+		else
+			stats.dataSent++;
+
+		slot->flags |= SLOT_SENT | SLOT_RESEND;
+		count--;
+	}
+
+	// Listen for the acknowledgement
+	radio->waitTX(NRF905_TX_TIMEOUT);
+	radio->RX();
+
+	// The poll frame didn't get sent because the channel was busy, that's not a loss so don't wait for an acknowledgement and back off
+	// The next service() call sends the rest of the burst
+	if(count)
+		return;
+
+	pollSentAt = micros();
+	waitingAck = true;
+}
+
+void nRF905Link::sendAck()
+{
+	// receive() might want another acknowledgement while this one is being sent
+	ackPending = false;
+
+	// Everything up to the first missing frame has been received
+	uint8_t ack = rxBase;
+	while((uint8_t)(ack - rxBase) < NRF905_LINK_WINDOW && (SLOT(rxSlots, ack)->flags & SLOT_USED))
+		ack++;
+
+	uint8_t bitmask = 0;
+	for(uint8_t i=0;i<8;i++)
+	{
+		uint8_t seq = ack + 1 + i;
+		if((uint8_t)(seq - rxBase) < NRF905_LINK_WINDOW && (SLOT(rxSlots, seq)->flags & SLOT_USED))
+			bitmask |= (1<<i);
+	}
+
+	uint8_t frame[3];
+	frame[0] = FRAME_ACK;
+	frame[1] = ack;
+	frame[2] = bitmask;
+
+	// Already in RX mode so the radio can go straight back to RX afterwards
+	// Try again next time if the channel stayed busy
+	if(!transmit(frame, sizeof(frame), NRF905_NEXTMODE_RX))
+	{
+		ackPending = true;
+		return;
+	}
+
+	stats.acksSent++;
+}
+
+void nRF905Link::processData(uint8_t* frame, uint8_t len)
+{
+	uint8_t dataLen = frame[0] & FRAME_LEN_MASK;
+	if(dataLen > NRF905_LINK_MAX_DATA || dataLen > len - 2)
+		return;
+
+	if(frame[0] & FRAME_POLL)
+		ackPending = true;
+
+	uint8_t seq = frame[1];
+	uint8_t offset = seq - rxBase;
+	if(offset >= NRF905_LINK_WINDOW)
+	{
+		// Either an old frame that was sent again because the acknowledgement got lost, or too far ahead because the application isn't reading
+		if(offset >= 128)
+			stats.dataDuplicate++;
+		else
+			stats.dataDropped++;
+		return;
+	}
+
+	slot_t* slot = SLOT(rxSlots, seq);
+	if(slot->flags & SLOT_USED)
+	{
+		stats.dataDuplicate++;
+		return;
+	}
+
+	slot->len = dataLen;
+	slot->flags = SLOT_USED;
+	memcpy(slot->data, &frame[2], dataLen);
+	stats.dataReceived++;
+}
+
+void nRF905Link::rttSample(unsigned long rtt)
+{
+	// Same as TCP (RFC 6298), RTO = SRTT + max(G, 4 * RTTVAR)
+	if(srtt == 0)
+	{
+		srtt = rtt;
+		rttvar = rtt / 2;
+	}
+	else
+	{
+		unsigned long diff = (rtt > srtt) ? (rtt - srtt) : (srtt - rtt);
+		rttvar = (rttvar * 3 + diff) / 4;
+		srtt = (srtt * 7 + rtt) / 8;
+	}
+
+	rto = srtt + (((rttvar * 4) > RTO_GRANULARITY) ? (rttvar * 4) : RTO_GRANULARITY);
+	if(rto < RTO_MIN)
+		rto = RTO_MIN;
+	else if(rto > RTO_MAX)
+		rto = RTO_MAX;
+}
+
+void nRF905Link::processAck(uint8_t* frame, uint8_t len)
+{
+	if(len < 3)
+		return;
+
+	uint8_t ack = frame[1];
+	uint8_t bitmask = frame[2];
+
+	// Ignore acknowledgements for frames that haven't been sent or were acknowledged a while ago
+	if((uint8_t)(ack - txBase) > (uint8_t)(txNext - txBase))
+		return;
+
+	stats.acksReceived++;
+
+	// Karn's algorithm, only measure the round trip time if the frame asking for the acknowledgement wasn't a resend
+	if(waitingAck && !pollResent)
+		rttSample(micros() - pollSentAt);
+	waitingAck = false;
+
+	// Everything before ack has arrived
+	while(txBase != ack)
+	{
+		SLOT(txSlots, txBase)->flags = 0;
+		txBase++;
+	}
+
+	// Frames after ack in the bitmask have also arrived and don't need sending again, anything else that was sent didn't arrive
+	for(uint8_t seq = txBase; seq != txNext; seq++)
+	{
+		slot_t* slot = SLOT(txSlots, seq);
+		uint8_t bit = seq - ack - 1;
+		if(bit < 8 && (bitmask & (1<<bit)))
+			slot->flags |= SLOT_SENT;
+		else
+			slot->flags &= ~SLOT_SENT;
+	}
+}
+
+void nRF905Link::processFrame(uint8_t* frame, uint8_t len)
+{
+	if(len < 2)
+		return;
+
+	switch(frame[0] & FRAME_TYPE_MASK)
+	{
+		case FRAME_DATA:
+			processData(frame, len);
+			break;
+		case FRAME_ACK:
+			processAck(frame, len);
+			break;
+		default:
+			break;
+	}
+}
+
+void nRF905Link::service()
+{
+	if(radio == NULL)
+		return;
+
+	if(radio->polled())
+		radio->poll();
+
+#if NRF905_RX_BUFFER_SLOTS
+	uint8_t frame[NRF905_MAX_PAYLOAD];
+	uint8_t len;
+	while((len = radio->readPacket(frame, sizeof(frame))))
+		processFrame(frame, len);
+#endif
+
+	if(rxFrameReady)
+	{
+		processFrame(rxFrame, sizeof(rxFrame));
+
+		// Make sure the frame has been handled before receive() can overwrite it
+		NRF905_MEMORY_BARRIER();
+		rxFrameReady = false;
+	}
+
+	if(ackPending)
+		sendAck();
+
+	if(waitingAck)
+	{
+		if((unsigned long)(micros() - pollSentAt) < rto)
+			return;
+
+		// Acknowledgement didn't arrive, send everything again and back off
+		stats.timeouts++;
+		waitingAck = false;
+		rto *= 2;
+		if(rto > RTO_MAX)
+			rto = RTO_MAX;
+
+		for(uint8_t seq = txBase; seq != txNext; seq++)
+			SLOT(txSlots, seq)->flags &= ~SLOT_SENT;
+	}
+
+	sendBurst();
+}
+
+void nRF905Link::getStats(nRF905_link_stats_t* stats)
+{
+	memcpy(stats, &this->stats, sizeof(nRF905_link_stats_t));
+	stats->srtt = srtt;
+	stats->rto = rto;
+}
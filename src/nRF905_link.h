@@ -0,0 +1,186 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_LINK_H_
+#define NRF905_LINK_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+#define NRF905_LINK_MAX_DATA	(NRF905_MAX_PAYLOAD - 2) ///< Maximum number of bytes that can be sent in one frame
+
+/**
+* @brief Link statistics
+*/
+typedef struct
+{
+	uint32_t dataSent; ///< Data frames sent for the first time
+	uint32_t dataResent; ///< Data frames sent again because they weren't acknowledged
+	uint32_t dataReceived; ///< New data frames received
+	uint32_t dataDuplicate; ///< Data frames received that had already been received
+	uint32_t dataDropped; ///< Data frames thrown away because the receive window was full
+	uint32_t acksSent; ///< Acknowledgements sent
+	uint32_t acksReceived; ///< Acknowledgements received
+	uint32_t timeouts; ///< Number of times an acknowledgement didn't arrive in time
+	uint32_t srtt; ///< Smoothed round trip time from the end of a burst to its acknowledgement (us)
+	uint32_t rto; ///< Current retransmission timeout (us)
+} nRF905_link_stats_t;
+
+/**
+* @brief Reliable, in-order delivery of frames between 2 radios
+*
+* Frames are numbered and sent in bursts of up to the window size (see .setWindow()), the last frame of each burst asks the other end to reply with an acknowledgement.
+* The acknowledgement says which frames have arrived so only the missing ones are sent again.
+* If the acknowledgement doesn't arrive in time then all unacknowledged frames are sent again and the timeout is doubled.
+* The timeout adapts to the measured round trip time.
+*
+* Received frames are held in the receive window until read with .read(), if the application stops reading then the window fills up and the other end stops sending new frames.
+*
+* Each end must use the same \p NRF905_LINK_WINDOW (see nRF905_config.h). The radio's payload size is set to ::NRF905_MAX_PAYLOAD.
+*
+* In interrupt mode call .receive() from the \p onRxComplete event, in polled mode call it after .poll() has run the event.
+* If \p NRF905_RX_BUFFER_SLOTS is enabled then .service() does this automatically instead.
+* .service() must be called often, it sends frames and acknowledgements and waits for each frame in a burst to finish sending.
+*/
+class nRF905Link
+{
+private:
+	typedef struct
+	{
+		uint8_t len;
+		uint8_t flags;
+		uint8_t data[NRF905_LINK_MAX_DATA];
+	} slot_t;
+
+	nRF905* radio;
+	uint32_t sendTo;
+	uint8_t window;
+
+	// Send window
+	slot_t txSlots[NRF905_LINK_WINDOW];
+	uint8_t txBase; // Oldest unacknowledged sequence number
+	uint8_t txNext; // Next sequence number to use
+	bool waitingAck;
+	bool pollResent;
+	unsigned long pollSentAt;
+	unsigned long rto;
+	unsigned long srtt;
+	unsigned long rttvar;
+
+	// Receive window
+	slot_t rxSlots[NRF905_LINK_WINDOW];
+	volatile uint8_t rxBase; // Next sequence number to be read by the application
+	volatile bool ackPending;
+
+	// Frame from receive() waiting for service()
+	uint8_t rxFrame[NRF905_MAX_PAYLOAD];
+	volatile bool rxFrameReady;
+
+	nRF905_link_stats_t stats;
+
+	bool transmit(uint8_t* frame, uint8_t len, nRF905_nextmode_t nextMode);
+	void sendBurst();
+	void sendAck();
+	void processFrame(uint8_t* frame, uint8_t len);
+	void processData(uint8_t* frame, uint8_t len);
+	void processAck(uint8_t* frame, uint8_t len);
+	void rttSample(unsigned long rtt);
+
+public:
+	nRF905Link();
+
+/**
+* @brief Attach to a radio
+*
+* The radio should have already been set up with .begin(). It is put into receive mode.
+*
+* Example: `link.begin(transceiver, 0xB54CAB34);`
+*
+* @param [radio] The radio
+* @param [sendTo] Address of the other end
+* @return (none)
+*/
+	void begin(nRF905& radio, uint32_t sendTo);
+
+/**
+* @brief Set how many frames can be sent before waiting for an acknowledgement
+*
+* Example: `link.setWindow(1);` for stop-and-wait
+*
+* @param [window] Window size (1 - \p NRF905_LINK_WINDOW, default \p NRF905_LINK_WINDOW)
+* @return (none)
+*/
+	void setWindow(uint8_t window);
+
+/**
+* @brief Queue a frame to be sent
+*
+* Example: `if(link.send(buffer, len))`
+*
+* @param [data] The data, this is copied into the send window
+* @param [len] Data length (max ::NRF905_LINK_MAX_DATA)
+* @return \p false if the send window is full, otherwise \p true
+*/
+	bool send(void* data, uint8_t len);
+
+/**
+* @brief Number of frames that have been queued with .send() but not acknowledged yet
+*
+* Example: `while(link.pending()) link.service();`
+*
+* @return Frame count
+*/
+	uint8_t pending();
+
+/**
+* @brief Read the next frame in order
+*
+* Example: `uint8_t len = link.read(buffer, sizeof(buffer));`
+*
+* @param [data] Buffer to copy the frame into
+* @param [len] Buffer size, the frame is cut short if it is bigger than this
+* @return Frame length, \p 0 if there are no frames to read
+*/
+	uint8_t read(void* data, uint8_t len);
+
+/**
+* @brief Read the received payload from the radio
+*
+* Call this from the \p onRxComplete event. Data frames are put straight into the receive window, acknowledgements are handled next time .service() is called.
+*
+* Example: `link.receive();`
+*
+* @return (none)
+*/
+	void receive();
+
+/**
+* @brief Send frames and acknowledgements, handle received frames and timeouts
+*
+* Call this as often as possible.
+*
+* Example: `link.service();`
+*
+* @return (none)
+*/
+	void service();
+
+/**
+* @brief Get a copy of the link statistics
+*
+* Example: `nRF905_link_stats_t stats; link.getStats(&stats);`
+*
+* @param [stats] Where to copy the statistics to
+* @return (none)
+*/
+	void getStats(nRF905_link_stats_t* stats);
+};
+
+#endif /* NRF905_LINK_H_ */
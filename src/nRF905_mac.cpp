@@ -0,0 +1,191 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_mac.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+// Time from another radio seeing a free channel to its preamble being on air (us)
+#define DEFAULT_SLOT_TIME		(NRF905_TX_SETTLE_TIME + NRF905_CALC_AIRTIME(0, 0, 0))
+
+#define DEFAULT_MIN_EXPONENT	3
+#define DEFAULT_MAX_EXPONENT	5
+#define DEFAULT_MAX_ATTEMPTS	5
+#define MAX_EXPONENT			15
+
+nRF905Mac::nRF905Mac()
+{
+	radio = NULL;
+	rng = 1;
+	slotTime = 0;
+	minExponent = DEFAULT_MIN_EXPONENT;
+	maxExponent = DEFAULT_MAX_EXPONENT;
+	maxAttempts = DEFAULT_MAX_ATTEMPTS;
+	status = NRF905_MAC_IDLE;
+	nextMode = NRF905_NEXTMODE_STANDBY;
+	exponent = 0;
+	attempts = 0;
+	startTime = 0;
+	backoffStart = 0;
+	backoffTime = 0;
+	memset(&stats, 0, sizeof(nRF905_mac_stats_t));
+}
+
+void nRF905Mac::begin(nRF905& radio, uint32_t seed)
+{
+	this->radio = &radio;
+	rng = seed ? seed : 1;
+}
+
+void nRF905Mac::setSlotTime(uint16_t slotTime)
+{
+	this->slotTime = slotTime;
+}
+
+void nRF905Mac::setBackoff(uint8_t minExponent, uint8_t maxExponent, uint8_t maxAttempts)
+{
+	if(minExponent > MAX_EXPONENT)
+		minExponent = MAX_EXPONENT;
+	if(maxExponent > MAX_EXPONENT)
+		maxExponent = MAX_EXPONENT;
+	if(maxExponent < minExponent)
+		maxExponent = minExponent;
+	if(maxAttempts < 1)
+		maxAttempts = 1;
+
+	this->minExponent = minExponent;
+	this->maxExponent = maxExponent;
+	this->maxAttempts = maxAttempts;
+}
+
+// Wait between 0 and 2^exponent - 1 slots
+void nRF905Mac::backoff()
+{
+	// xorshift32
+	rng ^= rng<<13;
+	rng ^= rng>>17;
+	rng ^= rng<<5;
+
+	uint16_t slot = slotTime ? slotTime : DEFAULT_SLOT_TIME;
+	backoffTime = (rng & ((1UL<<exponent) - 1)) * slot;
+	backoffStart = micros();
+}
+
+void nRF905Mac::finish(uint8_t status)
+{
+	this->status = status;
+
+	if(status == NRF905_MAC_SENT)
+		stats.sent++;
+	else
+		stats.failed++;
+
+	unsigned long time = micros() - startTime;
+	stats.backoffTimeTotal += time;
+	if(time > stats.backoffTimeMax)
+		stats.backoffTimeMax = time;
+}
+
+bool nRF905Mac::startTX(nRF905_nextmode_t nextMode)
+{
+	if(radio == NULL || status == NRF905_MAC_BACKOFF)
+		return false;
+
+	this->nextMode = nextMode;
+	exponent = minExponent;
+	attempts = 0;
+	status = NRF905_MAC_BACKOFF;
+	startTime = micros();
+
+	// Check the channel straight away, only back off once it has been seen busy
+	// A random wait before the first check only adds latency when the channel is usually free
+	backoffStart = startTime;
+	backoffTime = 0;
+
+	return true;
+}
+
+nRF905_mac_status_t nRF905Mac::service()
+{
+	if(radio == NULL)
+		return NRF905_MAC_IDLE;
+
+	if(radio->polled())
+		radio->poll();
+
+	// Finish off the previous transmission
+	bool radioIdle = radio->service();
+
+	if(status != NRF905_MAC_BACKOFF)
+		return (nRF905_mac_status_t)status;
+
+	if((unsigned long)(micros() - backoffStart) < backoffTime)
+		return NRF905_MAC_BACKOFF;
+
+	// Can't check the channel or change modes while the previous payload is still on air
+	if(!radioIdle || radio->transmitting())
+		return NRF905_MAC_BACKOFF;
+
+	// Carrier detect only works in receive mode, switch over and wait for it to settle before checking
+	nRF905_mode_t mode = radio->mode();
+	if(mode != NRF905_MODE_RX && mode != NRF905_MODE_ACTIVE)
+	{
+		radio->RX();
+		backoffStart = micros();
+		backoffTime = radio->wakeRemaining() + NRF905_RX_SETTLE_TIME;
+		return NRF905_MAC_BACKOFF;
+	}
+
+	if(radio->airwayBusy())
+	{
+		stats.busy++;
+
+		if(++attempts >= maxAttempts)
+			finish(NRF905_MAC_FAILED);
+		else
+		{
+			// First busy wait uses minExponent, each one after that gets a bigger window
+			backoff();
+			if(exponent < maxExponent)
+				exponent++;
+		}
+
+		return (nRF905_mac_status_t)status;
+	}
+
+	// Channel is free
+	finish(radio->startTX(nextMode, false) ? NRF905_MAC_SENT : NRF905_MAC_FAILED);
+	return (nRF905_mac_status_t)status;
+}
+
+bool nRF905Mac::TX(nRF905_nextmode_t nextMode)
+{
+	if(!startTX(nextMode))
+		return false;
+
+	nRF905_mac_status_t status;
+	while((status = service()) == NRF905_MAC_BACKOFF);
+
+	// Wait for the radio to get into nextMode
+	while(!radio->service());
+
+	return (status == NRF905_MAC_SENT);
+}
+
+void nRF905Mac::getStats(nRF905_mac_stats_t* stats)
+{
+	memcpy(stats, &this->stats, sizeof(nRF905_mac_stats_t));
+}
+
+void nRF905Mac::resetStats()
+{
+	memset(&stats, 0, sizeof(nRF905_mac_stats_t));
+}
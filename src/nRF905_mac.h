@@ -0,0 +1,176 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_MAC_H_
+#define NRF905_MAC_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+/**
+* @brief State of the transmission started by nRF905Mac::startTX()
+*/
+typedef enum
+{
+	NRF905_MAC_IDLE, ///< Nothing has been sent yet
+	NRF905_MAC_BACKOFF, ///< Waiting for the channel to be free
+	NRF905_MAC_SENT, ///< Transmission has started
+	NRF905_MAC_FAILED ///< Channel was busy for every attempt, or the radio refused to transmit (see nRF905::setDutyCycle())
+} nRF905_mac_status_t;
+
+/**
+* @brief Channel access statistics
+*/
+typedef struct
+{
+	uint32_t sent; ///< Transmissions started
+	uint32_t failed; ///< Transmissions given up on
+	uint32_t busy; ///< Number of times the channel was busy when checked
+	uint32_t backoffTimeTotal; ///< Total time spent backing off (us)
+	uint32_t backoffTimeMax; ///< Longest time a transmission spent backing off (us)
+} nRF905_mac_stats_t;
+
+/**
+* @brief Carrier sense multiple access with collision avoidance
+*
+* The channel is checked straight away and if it's free the transmission starts.
+* Instead of trying again straight away when the channel is busy (and colliding with everyone else who was waiting for the same transmission to finish), the transmission waits a random number of slots.
+* If the channel is busy again once the wait is over then the range the random wait is picked from doubles, up to a maximum, and it tries again.
+* After the maximum number of attempts the transmission is given up on.
+*
+* At low load this is no better than trying again straight away and adds about 1ms of latency (switching to receive mode to check the channel),
+* it starts to pay off once the channel is often busy. In the csma.cpp host simulator with 5 nodes delivery is about the same as plain retries,
+* with 20 and 40 nodes backoff delivers 3 - 5% more payloads with half the collisions.
+*
+* The radio is put into receive mode while waiting since the carrier detect pin only works in receive mode.
+*
+* Each radio must be given a different seed so that they don't all pick the same waits, the radio's listen address is a good choice.
+*/
+class nRF905Mac
+{
+private:
+	nRF905* radio;
+	uint32_t rng;
+	uint16_t slotTime;
+	uint8_t minExponent;
+	uint8_t maxExponent;
+	uint8_t maxAttempts;
+
+	// Transmission being sent
+	uint8_t status;
+	nRF905_nextmode_t nextMode;
+	uint8_t exponent;
+	uint8_t attempts;
+	unsigned long startTime;
+	unsigned long backoffStart;
+	unsigned long backoffTime;
+
+	nRF905_mac_stats_t stats;
+
+	void backoff();
+	void finish(uint8_t status);
+
+public:
+	nRF905Mac();
+
+/**
+* @brief Attach to a radio
+*
+* The radio should have already been set up with .begin().
+*
+* Example: `mac.begin(transceiver, RXADDR);`
+*
+* @param [radio] The radio
+* @param [seed] Random seed, must be different for each radio
+* @return (none)
+*/
+	void begin(nRF905& radio, uint32_t seed);
+
+/**
+* @brief Set the length of a backoff slot
+*
+* The default is the time it takes another radio to switch from receive to transmit mode and get its preamble on air, which is the window where 2 radios can both see a free channel and collide.
+*
+* Example: `mac.setSlotTime(2000);`
+*
+* @param [slotTime] Slot length in microseconds, \p 0 for the default
+* @return (none)
+*/
+	void setSlotTime(uint16_t slotTime);
+
+/**
+* @brief Set how the random wait grows
+*
+* The first wait is between 0 and 2^minExponent - 1 slots, each busy attempt adds 1 to the exponent up to \p maxExponent.
+* The default is 3, 5 and 5 attempts (same as IEEE 802.15.4).
+*
+* Example: `mac.setBackoff(2, 6, 8);`
+*
+* @param [minExponent] Starting exponent (0 - 15)
+* @param [maxExponent] Maximum exponent (\p minExponent - 15)
+* @param [maxAttempts] Number of times to check the channel before giving up (1 - 255)
+* @return (none)
+*/
+	void setBackoff(uint8_t minExponent, uint8_t maxExponent, uint8_t maxAttempts);
+
+/**
+* @brief Begin sending the payload once the channel is free
+*
+* The payload should have already been written with nRF905::write(), don't change it until .service() stops returning ::NRF905_MAC_BACKOFF.
+*
+* Example: `transceiver.write(0xB54CAB34, buffer, sizeof(buffer)); mac.startTX(NRF905_NEXTMODE_STANDBY);`
+*
+* @param [nextMode] What to do after the payload has been sent, see nRF905::TX()
+* @return \p false if the previous transmission is still backing off, otherwise \p true
+*/
+	bool startTX(nRF905_nextmode_t nextMode);
+
+/**
+* @brief Check the channel once the wait is over and start the transmission if it's free
+*
+* Call this as often as possible, it also calls nRF905::service() to finish off transmissions that have started.
+*
+* Example: `if(mac.service() == NRF905_MAC_FAILED)`
+*
+* @return State of the last transmission started by .startTX()
+*/
+	nRF905_mac_status_t service();
+
+/**
+* @brief Send the payload once the channel is free, waiting until it has been sent or given up on
+*
+* Example: `transceiver.write(0xB54CAB34, buffer, sizeof(buffer)); if(!mac.TX(NRF905_NEXTMODE_STANDBY))`
+*
+* @param [nextMode] What to do after the payload has been sent, see nRF905::TX()
+* @return \p true if the payload was sent, \p false if it was given up on
+*/
+	bool TX(nRF905_nextmode_t nextMode);
+
+/**
+* @brief Get a copy of the statistics
+*
+* Example: `nRF905_mac_stats_t stats; mac.getStats(&stats);`
+*
+* @param [stats] Where to copy the statistics to
+* @return (none)
+*/
+	void getStats(nRF905_mac_stats_t* stats);
+
+/**
+* @brief Set all statistics back to 0
+*
+* Example: `mac.resetStats();`
+*
+* @return (none)
+*/
+	void resetStats();
+};
+
+#endif /* NRF905_MAC_H_ */
@@ -0,0 +1,117 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_sleep.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+// Power up a little earlier than needed so the radio is definitely ready (us)
+#define WAKE_MARGIN			200
+
+nRF905Sleep::nRF905Sleep()
+{
+	radio = NULL;
+	powerDown = false;
+	awake = false;
+	awakeStart = 0;
+	awakeTotal = 0;
+	missedCount = 0;
+}
+
+void nRF905Sleep::begin(nRF905& radio, bool powerDown)
+{
+	this->radio = &radio;
+	this->powerDown = powerDown;
+	awake = false;
+	awakeTotal = 0;
+	missedCount = 0;
+	wake();
+}
+
+long nRF905Sleep::lead()
+{
+	return powerDown ? (NRF905_POWERUP_TIME + WAKE_MARGIN) : 0;
+}
+
+void nRF905Sleep::sleep(unsigned long wakeAt)
+{
+	// Stay in standby if there isn't enough time to power down and back up again
+	unsigned long now = micros();
+	if(powerDown && (long)(wakeAt - now) > lead())
+	{
+		radio->powerDown();
+		if(awake)
+			awakeTotal += now - awakeStart;
+		awake = false;
+	}
+	else
+	{
+		radio->standby();
+		if(awake && !powerDown)
+		{
+			awakeTotal += now - awakeStart;
+			awake = false;
+		}
+	}
+}
+
+void nRF905Sleep::wake()
+{
+	if(awake)
+		return;
+	awake = true;
+	awakeStart = micros();
+}
+
+bool nRF905Sleep::due(unsigned long wakeAt)
+{
+	unsigned long now = micros();
+
+	if(powerDown && !awake && (long)(now - wakeAt) >= -lead())
+	{
+		// Power up early so the radio is ready on time
+		radio->prepareWake();
+		wake();
+	}
+
+	if((long)(now - wakeAt) < 0)
+		return false;
+
+	wake();
+	return true;
+}
+
+uint32_t nRF905Sleep::remaining(unsigned long wakeAt)
+{
+	long remaining = (long)(wakeAt - micros());
+	if(powerDown && !awake)
+		remaining -= lead();
+	return (remaining > 0) ? remaining : 0;
+}
+
+bool nRF905Sleep::missed()
+{
+	if(missedCount < NRF905_SLEEP_MAX_MISSED)
+		missedCount++;
+	return (missedCount >= NRF905_SLEEP_MAX_MISSED);
+}
+
+void nRF905Sleep::heard()
+{
+	missedCount = 0;
+}
+
+uint32_t nRF905Sleep::onTime()
+{
+	if(awake)
+		return awakeTotal + (micros() - awakeStart);
+	return awakeTotal;
+}
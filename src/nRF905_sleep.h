@@ -0,0 +1,136 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_SLEEP_H_
+#define NRF905_SLEEP_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+#define NRF905_SLEEP_STATE_SEARCH	0 ///< Not in sync, listening until a beacon turns up
+#define NRF905_SLEEP_STATE_SLEEP	1 ///< Sleeping until the next wake up time
+#define NRF905_SLEEP_STATE_LISTEN	2 ///< Listening for a beacon
+#define NRF905_SLEEP_STATE_USER		3 ///< First state number free for the class using nRF905Sleep
+
+#define NRF905_SLEEP_MAX_MISSED		3 ///< Give up on the clock estimate and go back to searching after this many beacons in a row are missed
+#define NRF905_SLEEP_MAX_DRIFT		2000 ///< Drift measurements bigger than this must be wrong (ppm)
+
+/**
+* @brief Sleep a radio between scheduled wake up times and keep track of how long it has been awake
+*
+* Used by nRF905Sync and nRF905Tdma for nodes that listen for beacons on a schedule.
+* The radio is put into power-down mode while sleeping if there's enough time to power back up, otherwise standby mode.
+* When sleeping in power-down mode the radio is powered up early so that it's ready by the wake up time.
+*/
+class nRF905Sleep
+{
+private:
+	nRF905* radio;
+	bool powerDown;
+	bool awake;
+	unsigned long awakeStart;
+	uint32_t awakeTotal;
+	uint8_t missedCount;
+
+public:
+	nRF905Sleep();
+
+/**
+* @brief Start with the radio awake
+*
+* Example: `sleeper.begin(transceiver, true);`
+*
+* @param [radio] The radio
+* @param [powerDown] \p true to sleep in power-down mode (2.5uA, but takes 3ms to wake up), \p false to sleep in standby mode (32uA)
+* @return (none)
+*/
+	void begin(nRF905& radio, bool powerDown);
+
+/**
+* @brief How long before the wake up time .sleep() needs to be called for the radio to be ready on time
+*
+* Example: `long lead = sleeper.lead();`
+*
+* @return Time (us), \p 0 when sleeping in standby mode
+*/
+	long lead();
+
+/**
+* @brief Put the radio to sleep until the wake up time
+*
+* Example: `sleeper.sleep(listenTime);`
+*
+* @param [wakeAt] micros() time to wake up at
+* @return (none)
+*/
+	void sleep(unsigned long wakeAt);
+
+/**
+* @brief Start counting on-time if the radio isn't already awake
+*
+* Example: `sleeper.wake();`
+*
+* @return (none)
+*/
+	void wake();
+
+/**
+* @brief See if the wake up time has come, powering the radio up early if needed
+*
+* Call this often while sleeping.
+*
+* Example: `if(sleeper.due(listenTime))`
+*
+* @param [wakeAt] micros() time to wake up at
+* @return \p true once the wake up time has passed, otherwise \p false
+*/
+	bool due(unsigned long wakeAt);
+
+/**
+* @brief How long until .due() needs calling again
+*
+* Example: `uint32_t time = sleeper.remaining(listenTime);`
+*
+* @param [wakeAt] micros() time to wake up at
+* @return Time (us), \p 0 if .due() needs calling straight away
+*/
+	uint32_t remaining(unsigned long wakeAt);
+
+/**
+* @brief Count a beacon that was listened for but didn't turn up
+*
+* Example: `if(sleeper.missed())`
+*
+* @return \p true if ::NRF905_SLEEP_MAX_MISSED beacons in a row have been missed, otherwise \p false
+*/
+	bool missed();
+
+/**
+* @brief A beacon turned up, start counting missed beacons from 0 again
+*
+* Example: `sleeper.heard();`
+*
+* @return (none)
+*/
+	void heard();
+
+/**
+* @brief Total time the radio has been awake (powering up or listening) since .begin()
+*
+* Wraps around after about 71 minutes of on-time.
+*
+* Example: `Serial.println(sleeper.onTime());`
+*
+* @return On-time (us)
+*/
+	uint32_t onTime();
+};
+
+#endif /* NRF905_SLEEP_H_ */
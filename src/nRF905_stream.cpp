@@ -0,0 +1,221 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_stream.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+#if NRF905_STREAM_BUFFER_SIZE < 1 || NRF905_STREAM_BUFFER_SIZE > 128 || (NRF905_STREAM_BUFFER_SIZE & (NRF905_STREAM_BUFFER_SIZE - 1))
+	#error "NRF905_STREAM_BUFFER_SIZE must be a power of 2 and no more than 128"
+#endif
+
+// Frame header: SSSLLLLL, S = sequence number, L = data length
+#define HEADER_SEQ_SHIFT	5
+#define HEADER_SEQ_MASK		0x07
+#define HEADER_LEN_MASK		0x1F
+
+nRF905Stream::nRF905Stream()
+{
+	radio = NULL;
+	sendTo = 0;
+	fragmentSize = NRF905_MAX_PAYLOAD;
+	txLen = 0;
+	txSeq = 0;
+	rxHead = 0;
+	rxTail = 0;
+	rxSeq = 0;
+	rxSeqValid = false;
+	rxLost = 0;
+}
+
+void nRF905Stream::begin(nRF905& radio, uint32_t sendTo, uint8_t fragmentSize)
+{
+	if(fragmentSize < 2)
+		fragmentSize = 2;
+	else if(fragmentSize > NRF905_MAX_PAYLOAD)
+		fragmentSize = NRF905_MAX_PAYLOAD;
+
+	this->radio = &radio;
+	this->sendTo = sendTo;
+	this->fragmentSize = fragmentSize;
+
+	radio.setPayloadSize(fragmentSize, fragmentSize);
+	radio.RX();
+}
+
+bool nRF905Stream::sendFrame()
+{
+	if(!txLen)
+		return true;
+
+	txFrame[0] = (txSeq<<HEADER_SEQ_SHIFT) | txLen;
+
+	// The payload can't be changed while the previous frame is on air
+	radio->waitTX(NRF905_TX_TIMEOUT);
+
+	// Bytes after the data are left as whatever they were, the header says how many are valid
+	radio->write(sendTo, txFrame, txLen + 1);
+
+	// Standby so that DR goes high once the frame has been sent
+	// If the channel stays busy then keep the frame, the next write or flush will try again
+	if(!radio->TXWhenClear(NRF905_NEXTMODE_STANDBY, NRF905_CLEAR_TIMEOUT))
+		return false;
+
+	txSeq = (txSeq + 1) & HEADER_SEQ_MASK;
+	txLen = 0;
+	return true;
+}
+
+size_t nRF905Stream::write(uint8_t data)
+{
+	if(radio == NULL)
+		return 0;
+
+	// Frame is still full from an earlier send that couldn't get on air
+	if(txLen >= fragmentSize - 1 && !sendFrame())
+		return 0;
+
+	txFrame[++txLen] = data;
+	if(txLen >= fragmentSize - 1)
+		sendFrame();
+	return 1;
+}
+
+size_t nRF905Stream::write(const uint8_t* buffer, size_t size)
+{
+	if(radio == NULL)
+		return 0;
+
+	size_t remaining = size;
+	while(remaining)
+	{
+		uint8_t space = (fragmentSize - 1) - txLen;
+		if(space > remaining)
+			space = remaining;
+
+		memcpy(&txFrame[txLen + 1], buffer, space);
+		txLen += space;
+		buffer += space;
+		remaining -= space;
+
+		if(txLen >= fragmentSize - 1 && !sendFrame())
+			break;
+	}
+	return size - remaining;
+}
+
+void nRF905Stream::flush()
+{
+	if(radio == NULL)
+		return;
+
+	sendFrame();
+	radio->waitTX(NRF905_TX_TIMEOUT);
+	radio->RX();
+}
+
+void nRF905Stream::receiveFrame(uint8_t* frame, uint8_t len)
+{
+	if(len < 1)
+		return;
+
+	uint8_t seq = (frame[0]>>HEADER_SEQ_SHIFT) & HEADER_SEQ_MASK;
+	uint8_t dataLen = frame[0] & HEADER_LEN_MASK;
+	if(dataLen > len - 1)
+		dataLen = len - 1;
+
+	if(rxSeqValid)
+	{
+		// Same frame again
+		if(seq == rxSeq)
+			return;
+
+		// Frames between the last one and this one never arrived
+		rxLost += ((seq - rxSeq) & HEADER_SEQ_MASK) - 1;
+	}
+	rxSeq = seq;
+	rxSeqValid = true;
+
+	uint8_t space = NRF905_STREAM_BUFFER_SIZE - (uint8_t)(rxHead - rxTail);
+	if(dataLen > space)
+	{
+		rxLost++;
+		return;
+	}
+
+	uint8_t head = rxHead;
+	for(uint8_t i=0;i<dataLen;i++)
+		rxBuffer[(uint8_t)(head + i) & (NRF905_STREAM_BUFFER_SIZE - 1)] = frame[i + 1];
+
+	// Make sure the data is in the buffer before the reader can see it
+	NRF905_MEMORY_BARRIER();
+	rxHead = head + dataLen;
+}
+
+void nRF905Stream::receive()
+{
+	if(radio == NULL)
+		return;
+
+	uint8_t frame[NRF905_MAX_PAYLOAD];
+#if NRF905_RX_BUFFER_SLOTS
+	uint8_t len;
+	while((len = radio->readPacket(frame, sizeof(frame))))
+		receiveFrame(frame, len);
+#else
+	radio->read(frame, fragmentSize);
+	receiveFrame(frame, fragmentSize);
+#endif
+}
+
+void nRF905Stream::pull()
+{
+#if NRF905_RX_BUFFER_SLOTS
+	receive();
+#endif
+}
+
+uint16_t nRF905Stream::lostFrames()
+{
+	nRF905_irqstate_t irq = nRF905_irqSave();
+	uint16_t count = rxLost;
+	nRF905_irqRestore(irq);
+	return count;
+}
+
+int nRF905Stream::available()
+{
+	pull();
+	return (uint8_t)(rxHead - rxTail);
+}
+
+int nRF905Stream::read()
+{
+	pull();
+	if(rxHead == rxTail)
+		return -1;
+
+	uint8_t data = rxBuffer[rxTail & (NRF905_STREAM_BUFFER_SIZE - 1)];
+
+	// Make sure the byte has been read before the writer can reuse its space
+	NRF905_MEMORY_BARRIER();
+	rxTail++;
+
+	return data;
+}
+
+int nRF905Stream::peek()
+{
+	pull();
+	if(rxHead == rxTail)
+		return -1;
+	return rxBuffer[rxTail & (NRF905_STREAM_BUFFER_SIZE - 1)];
+}
@@ -0,0 +1,109 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_STREAM_H_
+#define NRF905_STREAM_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+/**
+* @brief Send and receive a stream of bytes, like Serial
+*
+* Bytes written are collected into frames of up to \p fragmentSize - 1 bytes and sent once a frame is full or .flush() is called.
+* Each frame starts with a 1 byte header containing a 3 bit sequence number and the number of data bytes,
+* so at 32 byte payloads 31 of every 32 bytes sent are data.
+*
+* Received frames are put back together in order into a buffer of \p NRF905_STREAM_BUFFER_SIZE bytes (see nRF905_config.h).
+* Repeated frames (from auto-retransmit) are thrown away, missing frames can't be recovered and are counted by .lostFrames().
+*
+* The radio goes into standby mode while sending frames and back into receive mode once .flush() is called.
+* If the channel stays busy for longer than \p NRF905_CLEAR_TIMEOUT then the frame is kept and .write() returns fewer bytes than it was given.
+* In interrupt mode call .receive() from the \p onRxComplete event, in polled mode call it after .poll() has run the event.
+* If \p NRF905_RX_BUFFER_SLOTS is enabled then .available(), .read() and .peek() do this automatically instead.
+*/
+class nRF905Stream : public Stream
+{
+private:
+	nRF905* radio;
+	uint32_t sendTo;
+	uint8_t fragmentSize;
+
+	uint8_t txFrame[NRF905_MAX_PAYLOAD];
+	uint8_t txLen;
+	uint8_t txSeq;
+
+	uint8_t rxBuffer[NRF905_STREAM_BUFFER_SIZE];
+	volatile uint8_t rxHead;
+	volatile uint8_t rxTail;
+	uint8_t rxSeq;
+	bool rxSeqValid;
+	uint16_t rxLost;
+
+	bool sendFrame();
+	void receiveFrame(uint8_t* frame, uint8_t len);
+	void pull();
+
+public:
+	nRF905Stream();
+
+/**
+* @brief Attach to a radio
+*
+* The radio should have already been set up with .begin(). Its payload size is changed to \p fragmentSize and it is put into receive mode.
+* Both ends must use the same \p fragmentSize, smaller fragments take less time on air when only a few bytes are sent at a time but have more header overhead.
+*
+* Example: `stream.begin(transceiver, 0xB54CAB34);`
+*
+* @param [radio] The radio
+* @param [sendTo] Address to send frames to
+* @param [fragmentSize] Payload size to use (2 - ::NRF905_MAX_PAYLOAD)
+* @return (none)
+*/
+	void begin(nRF905& radio, uint32_t sendTo, uint8_t fragmentSize = NRF905_MAX_PAYLOAD);
+
+/**
+* @brief Read the received payload from the radio into the stream
+*
+* Call this from the \p onRxComplete event.
+*
+* Example: `stream.receive();`
+*
+* @return (none)
+*/
+	void receive();
+
+/**
+* @brief Number of frames that were missing or didn't fit in the receive buffer
+*
+* Example: `Serial.println(stream.lostFrames());`
+*
+* @return Lost frame count
+*/
+	uint16_t lostFrames();
+
+	virtual size_t write(uint8_t data);
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	virtual int available();
+	virtual int read();
+	virtual int peek();
+
+/**
+* @brief Send any bytes that haven't been sent yet, wait for the transmission to finish and go back into receive mode
+*
+* Example: `stream.flush();`
+*
+* @return (none)
+*/
+	virtual void flush();
+	using Print::write;
+};
+
+#endif /* NRF905_STREAM_H_ */
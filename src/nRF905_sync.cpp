@@ -0,0 +1,381 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_sync.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+// Beacon: TT TT TT TT DD DD MAGIC SS II II, all little endian
+// T = master's micros() when the beacon finishes arriving, D = how late the beacon was sent (us), S = sequence number, I = beacon interval (ms)
+// The time and lateness come first so they can be patched in right before sending
+#define BEACON_MAGIC		0x5C
+
+// Smallest drift error to assume once the drift is known, clocks wander with temperature and age (ppm)
+#define RESIDUAL_MIN		2
+
+// Drift error to assume until a prediction has been checked against a beacon (ppm)
+#define RESIDUAL_START		50
+
+// Timestamping error from interrupt latency and micros() resolution (us)
+#define JITTER				20
+
+// Start listening a little before the beacon could start and keep listening a little after it should have finished (us)
+#define LISTEN_MARGIN		100
+
+// Longest time to go without a beacon, must be well below half the micros() wrap around so time comparisons still work (us)
+#define MAX_SPAN			1800000000UL
+
+nRF905Sync::nRF905Sync()
+{
+	radio = NULL;
+	syncAddr = 0;
+	isMaster = false;
+	interval = 0;
+	beaconTime = 0;
+	nextBeacon = 0;
+	seq = 0;
+	errorBound = 0;
+	isSynced = false;
+	driftValid = false;
+	driftPPM = 0;
+	residualPPM = RESIDUAL_START;
+	maxLate = 0;
+	lastLocal = 0;
+	lastMaster = 0;
+	lastLate = 0;
+	state = NRF905_SLEEP_STATE_SEARCH;
+	listenTime = 0;
+	listenLen = 0;
+	stateStart = 0;
+	beaconReady = false;
+	beaconTimestamp = 0;
+}
+
+void nRF905Sync::beginMaster(nRF905& radio, uint32_t syncAddr, uint16_t interval)
+{
+	this->radio = &radio;
+	this->syncAddr = syncAddr;
+	this->interval = interval ? interval : 1;
+	isMaster = true;
+	beaconTime = NRF905_TX_SETTLE_TIME + radio.airtime();
+
+	// Send the first beacon once the radio has had time to power up
+	nextBeacon = micros() + NRF905_POWERUP_TIME;
+
+	radio.RX();
+}
+
+void nRF905Sync::beginNode(nRF905& radio, uint32_t syncAddr, uint16_t errorBound, bool powerDown)
+{
+	this->radio = &radio;
+	this->syncAddr = syncAddr;
+	this->errorBound = errorBound;
+	isMaster = false;
+	isSynced = false;
+	driftValid = false;
+	driftPPM = 0;
+	residualPPM = RESIDUAL_START;
+	maxLate = 0;
+	beaconReady = false;
+
+	// Beacons are sent with the address size and payload size that this radio receives with
+	beaconTime = NRF905_TX_SETTLE_TIME + radio.rxAirtime();
+
+	radio.setListenAddress(syncAddr);
+	radio.RX();
+	sleeper.begin(radio, powerDown);
+	state = NRF905_SLEEP_STATE_SEARCH;
+}
+
+void nRF905Sync::sendBeacon()
+{
+	uint8_t size = radio->getPayloadSizeTX();
+	if(size < NRF905_SYNC_BEACON_SIZE)
+		return;
+
+	memset(beacon, 0, sizeof(beacon));
+	beacon[6] = BEACON_MAGIC;
+	beacon[7] = seq++;
+	nRF905_put16(&beacon[8], interval);
+	radio->write(syncAddr, beacon, size);
+
+	// Timestamp as late as possible, the time and lateness are written over the start of the payload that's already in the radio
+	unsigned long now = micros();
+	unsigned long late = now - nextBeacon;
+	if(late > 0xFFFF)
+	{
+		nextBeacon = now;
+		late = 0;
+	}
+	nextBeacon += interval * 1000UL;
+
+	nRF905_put32(&beacon[0], now + beaconTime);
+	nRF905_put16(&beacon[4], late);
+	radio->patchPayload(beacon, 6);
+	radio->startTX(NRF905_NEXTMODE_RX, false);
+}
+
+void nRF905Sync::processBeacon()
+{
+	uint8_t* b = beacon;
+	if(b[6] != BEACON_MAGIC || !nRF905_get16(&b[8]))
+		return;
+
+	unsigned long master = nRF905_get32(&b[0]);
+	uint16_t late = nRF905_get16(&b[4]);
+	uint16_t newInterval = nRF905_get16(&b[8]);
+	unsigned long local = beaconTimestamp;
+
+	if(isSynced && newInterval == interval)
+	{
+		// Compare the time between beacons on this clock with what the master says it was
+		unsigned long elapsedLocal = local - lastLocal;
+		unsigned long elapsedMaster = master - lastMaster;
+		if(elapsedMaster && elapsedMaster < MAX_SPAN)
+		{
+			float measured = ((long)(elapsedLocal - elapsedMaster) * 1000000.0f) / elapsedMaster;
+			if(measured > -NRF905_SLEEP_MAX_DRIFT && measured < NRF905_SLEEP_MAX_DRIFT)
+			{
+				if(driftValid)
+				{
+					// See how far out the prediction was, anything more than the timestamping error means the drift estimate is off
+					long error = (long)(elapsedMaster - (elapsedLocal - (long)(elapsedLocal * (driftPPM / 1000000.0f))));
+					if(error < 0)
+						error = -error;
+					float rate = (error > JITTER) ? ((error - JITTER) * 1000000.0f) / elapsedMaster : 0;
+
+					// Be quick to believe things got worse and slow to believe they got better
+					if(rate > residualPPM)
+						residualPPM = rate;
+					else
+						residualPPM += (rate - residualPPM) / 8;
+
+					driftPPM += (measured - driftPPM) / 4;
+				}
+				else
+				{
+					driftPPM = measured;
+					residualPPM = RESIDUAL_START;
+					driftValid = true;
+				}
+			}
+			else
+				driftValid = false; // Master might have restarted, measure again from this beacon
+		}
+	}
+
+	if(late > maxLate)
+		maxLate = late;
+
+	interval = newInterval;
+	lastLocal = local;
+	lastMaster = master;
+	lastLate = late;
+	isSynced = true;
+	sleeper.heard();
+}
+
+// How far out the master time estimate could be this long after the last beacon
+uint32_t nRF905Sync::errorAt(uint32_t elapsed)
+{
+	if(!driftValid)
+		return JITTER + (uint32_t)(elapsed * (NRF905_SLEEP_MAX_DRIFT / 1000000.0f));
+
+	float residual = (residualPPM > RESIDUAL_MIN) ? residualPPM : RESIDUAL_MIN;
+	return JITTER + (uint32_t)(elapsed * (residual / 1000000.0f));
+}
+
+// Work out when to listen for the next beacon, skipping as many as the error bound allows if next is true
+void nRF905Sync::plan(bool next)
+{
+	unsigned long now = micros();
+	long lead = sleeper.lead();
+	uint32_t intervalUs = interval * 1000UL;
+
+	// Furthest beacon that can be waited for without the error going over the bound
+	uint32_t beacons = 1;
+	if(next && driftValid && errorBound > JITTER)
+	{
+		float residual = (residualPPM > RESIDUAL_MIN) ? residualPPM : RESIDUAL_MIN;
+		float span = ((errorBound - JITTER) * 1000000.0f) / residual;
+		if(span > MAX_SPAN)
+			span = MAX_SPAN;
+		beacons = span / intervalUs;
+		if(!beacons)
+			beacons = 1;
+	}
+
+	while(1)
+	{
+		// Beacons are scheduled on the master's clock, convert to this clock
+		uint32_t offset = (beacons * intervalUs) - lastLate;
+		uint32_t local = offset + (long)(offset * (driftPPM / 1000000.0f));
+
+		// Listen for long enough to cover the clock error either way and the master sending late
+		uint32_t widen = errorAt(local);
+		listenTime = lastLocal + local - beaconTime - widen - LISTEN_MARGIN;
+		listenLen = beaconTime + (widen * 2) + maxLate + (LISTEN_MARGIN * 2);
+
+		if((long)(listenTime - now) >= lead || (beacons + 1) * intervalUs > MAX_SPAN)
+			break;
+		beacons++;
+	}
+}
+
+void nRF905Sync::sleep(bool next)
+{
+	plan(next);
+	sleeper.sleep(listenTime);
+	state = NRF905_SLEEP_STATE_SLEEP;
+}
+
+void nRF905Sync::service()
+{
+	if(radio == NULL)
+		return;
+
+	if(radio->polled())
+		radio->poll();
+
+	if(isMaster)
+	{
+		if(!radio->service() || (long)(micros() - nextBeacon) < 0)
+			return;
+
+		// The timestamp would be wrong if startTX() had to wait for the radio to power up
+		if(radio->mode() == NRF905_MODE_POWERDOWN)
+			radio->prepareWake();
+		if(radio->wakeRemaining())
+			return;
+
+		sendBeacon();
+		return;
+	}
+
+	radio->service();
+
+#if NRF905_RX_BUFFER_SLOTS
+	if(!beaconReady)
+	{
+		memset(beacon, 0, sizeof(beacon));
+		if(radio->readPacket(beacon, sizeof(beacon), &beaconTimestamp))
+			beaconReady = true;
+	}
+#endif
+
+	if(beaconReady)
+	{
+		if(state == NRF905_SLEEP_STATE_SEARCH || state == NRF905_SLEEP_STATE_LISTEN)
+		{
+			processBeacon();
+			if(isSynced)
+				sleep(true);
+		}
+
+		// Make sure the beacon has been handled before receive() can overwrite it
+		NRF905_MEMORY_BARRIER();
+		beaconReady = false;
+	}
+
+	unsigned long now = micros();
+
+	switch(state)
+	{
+		case NRF905_SLEEP_STATE_SLEEP:
+			if(!sleeper.due(listenTime))
+				break;
+
+			stateStart = now;
+			radio->RX();
+			state = NRF905_SLEEP_STATE_LISTEN;
+			break;
+		case NRF905_SLEEP_STATE_LISTEN:
+			if((unsigned long)(now - stateStart) < listenLen || radio->receiveBusy())
+				break;
+
+			if(sleeper.missed())
+			{
+				// Clock estimate must be too far out, stay listening until a beacon turns up and measure the drift again
+				isSynced = false;
+				driftValid = false;
+				state = NRF905_SLEEP_STATE_SEARCH;
+			}
+			else
+				sleep(false); // Try the next beacon instead of skipping ahead
+			break;
+		default:
+			break;
+	}
+}
+
+uint32_t nRF905Sync::sleepTime()
+{
+	if(radio == NULL)
+		return 0;
+
+	if(isMaster)
+	{
+		long remaining = (long)(nextBeacon - micros());
+		return (remaining > 0) ? remaining : 0;
+	}
+	if(state == NRF905_SLEEP_STATE_SLEEP && !beaconReady)
+		return sleeper.remaining(listenTime);
+	return 0;
+}
+
+void nRF905Sync::receive()
+{
+	if(radio == NULL || isMaster || beaconReady)
+		return;
+
+	memset(beacon, 0, sizeof(beacon));
+	radio->read(beacon, radio->getPayloadSizeRX());
+	beaconTimestamp = radio->rxTimestamp();
+
+	// Make sure the beacon is in the buffer before service() can see it
+	NRF905_MEMORY_BARRIER();
+	beaconReady = true;
+}
+
+unsigned long nRF905Sync::time()
+{
+	if(isMaster)
+		return micros();
+	if(!isSynced)
+		return 0;
+
+	unsigned long elapsed = micros() - lastLocal;
+	return lastMaster + elapsed - (long)(elapsed * (driftPPM / 1000000.0f));
+}
+
+uint32_t nRF905Sync::error()
+{
+	if(isMaster)
+		return 0;
+	if(!isSynced || !driftValid)
+		return 0xFFFFFFFF;
+	return errorAt(micros() - lastLocal);
+}
+
+bool nRF905Sync::synced()
+{
+	return isSynced;
+}
+
+float nRF905Sync::drift()
+{
+	return driftPPM;
+}
+
+uint32_t nRF905Sync::onTime()
+{
+	return sleeper.onTime();
+}
@@ -0,0 +1,192 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_SYNC_H_
+#define NRF905_SYNC_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_sleep.h"
+#include "nRF905_config.h"
+
+#define NRF905_SYNC_BEACON_SIZE	10 ///< Beacon size, the master's transmit payload size and the nodes' receive payload size must be at least this big
+
+/**
+* @brief Keep the micros() clocks of a group of nodes in sync with a master
+*
+* The master sends a beacon every interval containing its micros() time at the moment the beacon finishes arriving.
+* Nodes timestamp each beacon when DR goes high (see .rxTimestamp()) and pair that with the master's time.
+* From pairs of beacons a node works out how fast or slow its clock runs compared to the master's clock and how well that estimate has been predicting the next beacon.
+* It then skips as many beacons as it can while still keeping its error within the error bound, sleeping the radio in between, so a stable clock ends up listening very rarely.
+*
+* The master's time is written into the beacon just before it is sent (see .patchPayload()), so there's no need for a follow-up message with the real send time.
+*
+* Nodes: In interrupt mode call .receive() from the \p onRxComplete event, in polled mode call it after .poll() has run the event.
+* If \p NRF905_RX_BUFFER_SLOTS is enabled then .service() does this automatically instead using the timestamp saved with the payload.
+* .service() must be called often on both the master and the nodes, how late it's called on the master only affects how long the nodes listen for.
+*/
+class nRF905Sync
+{
+private:
+	nRF905* radio;
+	uint32_t syncAddr;
+	bool isMaster;
+	uint16_t interval; // ms
+	uint16_t beaconTime; // TX settle time + beacon airtime
+
+	// Master
+	unsigned long nextBeacon;
+	uint8_t seq;
+
+	// Node
+	uint16_t errorBound;
+	bool isSynced;
+	bool driftValid;
+	float driftPPM;
+	float residualPPM;
+	uint16_t maxLate;
+	unsigned long lastLocal; // Local time of the last beacon
+	unsigned long lastMaster; // Master time of the last beacon
+	uint16_t lastLate;
+
+	uint8_t state;
+	unsigned long listenTime;
+	unsigned long listenLen;
+	unsigned long stateStart;
+	nRF905Sleep sleeper;
+
+	uint8_t beacon[NRF905_MAX_PAYLOAD];
+	volatile bool beaconReady;
+	unsigned long beaconTimestamp;
+
+	void sendBeacon();
+	void processBeacon();
+	uint32_t errorAt(uint32_t elapsed);
+	void plan(bool next);
+	void sleep(bool next);
+
+public:
+	nRF905Sync();
+
+/**
+* @brief Start sending beacons as the master
+*
+* The radio should have already been set up with .begin() and its payload sizes set. It is put into receive mode between beacons.
+*
+* Example: `sync.beginMaster(transceiver, 0x3C8E51A7, 1000);`
+*
+* @param [radio] The radio
+* @param [syncAddr] Address to send beacons to
+* @param [interval] Time between beacons (ms)
+* @return (none)
+*/
+	void beginMaster(nRF905& radio, uint32_t syncAddr, uint16_t interval);
+
+/**
+* @brief Start as a node and listen for the first beacon
+*
+* The radio should have already been set up with .begin() and its payload sizes set. The listen address is changed to the sync address.
+* The node listens for every beacon until it has worked out its clock drift, then starts skipping beacons.
+*
+* Example: `sync.beginNode(transceiver, 0x3C8E51A7, 500, true);`
+*
+* @param [radio] The radio
+* @param [syncAddr] Address the master sends beacons to
+* @param [errorBound] Largest error .time() should have (us), a bigger bound means fewer beacons have to be listened for
+* @param [powerDown] \p true to sleep in power-down mode (2.5uA, but takes 3ms to wake up), \p false to sleep in standby mode (32uA)
+* @return (none)
+*/
+	void beginNode(nRF905& radio, uint32_t syncAddr, uint16_t errorBound, bool powerDown);
+
+/**
+* @brief Send beacons, or wake up, listen and go back to sleep when needed
+*
+* Call this as often as possible.
+*
+* Example: `sync.service();`
+*
+* @return (none)
+*/
+	void service();
+
+/**
+* @brief How long until .service() next has something to do
+*
+* A node can put the MCU to sleep for this long (as long as the radio's interrupts can still wake it up).
+*
+* Example: `uint32_t time = sync.sleepTime();`
+*
+* @return Time (us), \p 0 if .service() needs calling straight away
+*/
+	uint32_t sleepTime();
+
+/**
+* @brief Read a beacon from the radio
+*
+* Node only. Call this from the \p onRxComplete event.
+*
+* Example: `sync.receive();`
+*
+* @return (none)
+*/
+	void receive();
+
+/**
+* @brief The master's micros() time
+*
+* On the master this is just micros(). On a node it's worked out from the last beacon and the clock drift.
+*
+* Example: `unsigned long now = sync.time();`
+*
+* @return Master time (us), \p 0 if not in sync yet
+*/
+	unsigned long time();
+
+/**
+* @brief How far out .time() might be right now
+*
+* Node only. This is worked out from how well the node has been predicting the beacons, it grows the longer it's been since the last beacon.
+*
+* Example: `Serial.println(sync.error());`
+*
+* @return Estimated error (us), \p 0xFFFFFFFF if the clock drift isn't known yet
+*/
+	uint32_t error();
+
+/**
+* @brief See if the node has heard a beacon recently enough to know the master's time
+*
+* Example: `if(sync.synced())`
+*
+* @return \p true if in sync, otherwise \p false
+*/
+	bool synced();
+
+/**
+* @brief How fast the node's clock runs compared to the master's clock
+*
+* Example: `Serial.println(sync.drift());`
+*
+* @return Parts per million, positive means the node's clock is fast
+*/
+	float drift();
+
+/**
+* @brief Total time the radio has been awake (powering up or listening) since .beginNode()
+*
+* Wraps around after about 71 minutes of on-time.
+*
+* Example: `Serial.println(sync.onTime());`
+*
+* @return On-time (us)
+*/
+	uint32_t onTime();
+};
+
+#endif /* NRF905_SYNC_H_ */
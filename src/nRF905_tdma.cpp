@@ -0,0 +1,464 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_tdma.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+#if NRF905_TDMA_ASSIGNMENTS < 1 || NRF905_TDMA_ASSIGNMENTS > 255
+	#error "NRF905_TDMA_ASSIGNMENTS must be between 1 and 255"
+#endif
+
+// Beacon: MAGIC FF SS SS LL LL GG GG BB BB DD DD (II II NN NN)..., all little endian
+// F = frame number, S = slot count, L = slot length (us), G = guard time (us), B = beacon time (us), D = how late the beacon was sent (us), I = node ID, N = slot number
+// Unused assignments are filled with 0xFF
+#define BEACON_MAGIC		0xD5
+#define NO_ID				0xFFFF
+
+// States, along with the nRF905Sleep ones
+#define STATE_SENDING		NRF905_SLEEP_STATE_USER
+
+// What to do once the sleep is over
+#define ACTION_LISTEN		0
+#define ACTION_SEND			1
+
+// How far out the drift estimate might be (ppm)
+#define DRIFT_RESIDUAL		10
+
+nRF905Tdma::nRF905Tdma()
+{
+	radio = NULL;
+	beaconAddr = 0;
+	isBase = false;
+	frameNumber = 0;
+	slotCount = 0;
+	slotLen = 0;
+	guard = 0;
+	beaconTime = 0;
+	frameStart = 0;
+	memset(assignments, 0, sizeof(assignments));
+	assignmentCount = 0;
+	assignmentNext = 0;
+	id = 0;
+	resync = 1;
+	isSynced = false;
+	driftValid = false;
+	driftPPM = 0;
+	slotAssigned = false;
+	assignedSlot = 0;
+	state = NRF905_SLEEP_STATE_SEARCH;
+	action = ACTION_LISTEN;
+	actionTime = 0;
+	listenWiden = 0;
+	stateStart = 0;
+	sendTo = 0;
+	txLen = 0;
+	txPending = false;
+	beaconReady = false;
+	beaconTimestamp = 0;
+}
+
+void nRF905Tdma::beginBase(nRF905& radio, uint32_t beaconAddr, uint16_t slots, uint16_t guard)
+{
+	this->radio = &radio;
+	this->beaconAddr = beaconAddr;
+	this->guard = guard;
+	isBase = true;
+	slotCount = slots ? slots : 1;
+
+	// Nodes send with the address size and payload size that this radio receives with
+	slotLen = (guard * 2UL) + NRF905_TX_SETTLE_TIME + radio.rxAirtime();
+	beaconTime = NRF905_TX_SETTLE_TIME + radio.airtime();
+
+	// Send the first beacon once the radio has had time to power up
+	frameStart = micros() - frameTime() + NRF905_POWERUP_TIME;
+
+	radio.RX();
+}
+
+void nRF905Tdma::beginNode(nRF905& radio, uint32_t beaconAddr, uint16_t id, bool powerDown, uint8_t resync)
+{
+	this->radio = &radio;
+	this->beaconAddr = beaconAddr;
+	this->id = id;
+	this->resync = resync ? resync : 1;
+	isBase = false;
+	isSynced = false;
+	driftValid = false;
+	driftPPM = 0;
+	slotAssigned = false;
+	txPending = false;
+	beaconReady = false;
+
+	radio.setListenAddress(beaconAddr);
+	radio.RX();
+	sleeper.begin(radio, powerDown);
+	state = NRF905_SLEEP_STATE_SEARCH;
+}
+
+bool nRF905Tdma::assign(uint16_t id, uint16_t slot)
+{
+	for(uint8_t i=0;i<assignmentCount;i++)
+	{
+		if(assignments[i].id == id)
+		{
+			assignments[i].slot = slot;
+			return true;
+		}
+	}
+
+	if(assignmentCount >= NRF905_TDMA_ASSIGNMENTS)
+		return false;
+
+	assignments[assignmentCount].id = id;
+	assignments[assignmentCount].slot = slot;
+	assignmentCount++;
+	return true;
+}
+
+bool nRF905Tdma::send(uint32_t sendTo, void* data, uint8_t len)
+{
+	if(radio == NULL || isBase || txPending)
+		return false;
+
+	if(len > NRF905_MAX_PAYLOAD)
+		len = NRF905_MAX_PAYLOAD;
+
+	this->sendTo = sendTo;
+	memcpy(txBuffer, data, len);
+	txLen = len;
+	txPending = true;
+
+	// The slot might come before the next beacon
+	if(state == NRF905_SLEEP_STATE_SLEEP && action == ACTION_LISTEN)
+		plan();
+
+	return true;
+}
+
+bool nRF905Tdma::pending()
+{
+	return txPending;
+}
+
+// Beacon slot, a guard time and then the node slots
+uint32_t nRF905Tdma::frameTime()
+{
+	return beaconTime + guard + ((uint32_t)slotCount * slotLen);
+}
+
+// Local time of a point in a frame, counting frames from the last beacon and correcting for clock drift
+unsigned long nRF905Tdma::frameOffset(uint32_t frames, uint32_t offset)
+{
+	uint32_t time = (frames * frameTime()) + offset;
+	return frameStart + time + (long)(time * (driftPPM / 1000000.0f));
+}
+
+void nRF905Tdma::sendBeacon()
+{
+	uint8_t size = radio->getPayloadSizeTX();
+	if(size < NRF905_TDMA_BEACON_HEADER)
+		return;
+
+	memset(beacon, 0xFF, sizeof(beacon));
+	beacon[0] = BEACON_MAGIC;
+	nRF905_put16(&beacon[1], frameNumber);
+	nRF905_put16(&beacon[3], slotCount);
+	nRF905_put16(&beacon[5], slotLen);
+	nRF905_put16(&beacon[7], guard);
+	nRF905_put16(&beacon[9], beaconTime);
+
+	// service() might not have been called exactly at the start of the frame, tell the nodes how far out it was so they can allow for it
+	unsigned long late = micros() - frameStart;
+	if(late > 0xFFFF)
+	{
+		frameStart += late;
+		late = 0;
+	}
+	nRF905_put16(&beacon[11], late);
+
+	// Take turns sending the assignments that don't fit
+	uint8_t count = (size - NRF905_TDMA_BEACON_HEADER) / 4;
+	if(count > assignmentCount)
+		count = assignmentCount;
+	for(uint8_t i=0;i<count;i++)
+	{
+		if(assignmentNext >= assignmentCount)
+			assignmentNext = 0;
+		nRF905_put16(&beacon[NRF905_TDMA_BEACON_HEADER + (i * 4)], assignments[assignmentNext].id);
+		nRF905_put16(&beacon[NRF905_TDMA_BEACON_HEADER + (i * 4) + 2], assignments[assignmentNext].slot);
+		assignmentNext++;
+	}
+
+	radio->write(beaconAddr, beacon, size);
+	radio->startTX(NRF905_NEXTMODE_RX, false);
+}
+
+void nRF905Tdma::processBeacon()
+{
+	uint8_t* b = beacon;
+	if(b[0] != BEACON_MAGIC || !nRF905_get16(&b[3]) || !nRF905_get16(&b[5]))
+		return;
+
+	uint16_t newFrame = nRF905_get16(&b[1]);
+	uint16_t newSlotCount = nRF905_get16(&b[3]);
+	uint16_t newSlotLen = nRF905_get16(&b[5]);
+	uint16_t newGuard = nRF905_get16(&b[7]);
+	uint16_t newBeaconTime = nRF905_get16(&b[9]);
+	uint16_t late = nRF905_get16(&b[11]);
+
+	// The beacon started being sent its TX settle time plus airtime before it arrived
+	unsigned long newStart = beaconTimestamp - newBeaconTime - late;
+
+	// Compare the time between beacons on this clock with what the base station says it was
+	if(isSynced && newSlotCount == slotCount && newSlotLen == slotLen && newGuard == guard && newBeaconTime == beaconTime)
+	{
+		uint16_t frames = newFrame - frameNumber;
+		if(frames)
+		{
+			uint32_t expected = frames * frameTime();
+			long error = (long)((newStart - frameStart) - expected);
+			float measured = (error * 1000000.0f) / expected;
+			if(measured > -NRF905_SLEEP_MAX_DRIFT && measured < NRF905_SLEEP_MAX_DRIFT)
+			{
+				if(driftValid)
+					driftPPM += (measured - driftPPM) / 4;
+				else
+					driftPPM = measured;
+				driftValid = true;
+			}
+		}
+	}
+
+	frameNumber = newFrame;
+	slotCount = newSlotCount;
+	slotLen = newSlotLen;
+	guard = newGuard;
+	beaconTime = newBeaconTime;
+	frameStart = newStart;
+	isSynced = true;
+	sleeper.heard();
+
+	for(uint8_t i=NRF905_TDMA_BEACON_HEADER;i<=NRF905_MAX_PAYLOAD-4;i+=4)
+	{
+		if(nRF905_get16(&b[i]) == id && id != NO_ID)
+		{
+			slotAssigned = true;
+			assignedSlot = nRF905_get16(&b[i + 2]);
+		}
+	}
+}
+
+// Work out when to wake up next, for a beacon or for the node's slot, whichever comes first
+void nRF905Tdma::plan()
+{
+	unsigned long now = micros();
+	long lead = sleeper.lead();
+
+	// Frames since the last beacon, including the one going on now
+	unsigned long elapsed = now - frameStart;
+	uint32_t frames = (elapsed - (long)(elapsed * (driftPPM / 1000000.0f))) / frameTime();
+
+	// Until the drift is known the clock could be out by too much to wait for long, so get the next beacon as well
+	uint8_t interval = driftValid ? resync : 1;
+	uint32_t beaconFrame = (frames >= interval) ? frames + 1 : interval;
+	while(1)
+	{
+		// The clock could have gone either way since the last beacon, listen for long enough to cover it
+		listenWiden = (beaconFrame * frameTime()) * ((driftValid ? DRIFT_RESIDUAL : NRF905_SLEEP_MAX_DRIFT) / 1000000.0f);
+		if((long)(frameOffset(beaconFrame, 0) - guard - listenWiden - now) >= lead)
+			break;
+		beaconFrame++;
+	}
+
+	action = ACTION_LISTEN;
+	actionTime = frameOffset(beaconFrame, 0) - guard - listenWiden;
+
+	// Slot timing isn't good enough to send until the drift is known
+	if(txPending && driftValid)
+	{
+		// Start transmitting one guard time into the slot
+		uint32_t offset = beaconTime + guard + ((uint32_t)slot() * slotLen) + guard;
+		while((long)(frameOffset(frames, offset) - now) < lead)
+			frames++;
+
+		if(frames < beaconFrame)
+		{
+			action = ACTION_SEND;
+			actionTime = frameOffset(frames, offset);
+		}
+	}
+}
+
+void nRF905Tdma::sleep()
+{
+	plan();
+	sleeper.sleep(actionTime);
+	state = NRF905_SLEEP_STATE_SLEEP;
+}
+
+void nRF905Tdma::service()
+{
+	if(radio == NULL)
+		return;
+
+	if(radio->polled())
+		radio->poll();
+
+	radio->service();
+
+	if(isBase)
+	{
+		if((unsigned long)(micros() - frameStart) < frameTime())
+			return;
+
+		// Keep to the schedule even if this was called a bit late
+		frameStart += frameTime();
+
+		frameNumber++;
+		sendBeacon();
+		return;
+	}
+
+#if NRF905_RX_BUFFER_SLOTS
+	if(!beaconReady)
+	{
+		memset(beacon, 0xFF, sizeof(beacon));
+		if(radio->readPacket(beacon, sizeof(beacon), &beaconTimestamp))
+			beaconReady = true;
+	}
+#endif
+
+	if(beaconReady)
+	{
+		if(state == NRF905_SLEEP_STATE_SEARCH || state == NRF905_SLEEP_STATE_LISTEN)
+		{
+			processBeacon();
+			if(isSynced)
+				sleep();
+		}
+
+		// Make sure the beacon has been handled before receive() can overwrite it
+		NRF905_MEMORY_BARRIER();
+		beaconReady = false;
+	}
+
+	unsigned long now = micros();
+	unsigned long elapsed = now - stateStart;
+
+	switch(state)
+	{
+		case NRF905_SLEEP_STATE_SLEEP:
+			if(!sleeper.due(actionTime))
+				break;
+
+			stateStart = now;
+
+			if(action == ACTION_SEND)
+			{
+				radio->write(sendTo, txBuffer, txLen);
+				if(radio->startTX(NRF905_NEXTMODE_STANDBY, false))
+					state = STATE_SENDING;
+				else
+					sleep();
+			}
+			else
+			{
+				radio->RX();
+				state = NRF905_SLEEP_STATE_LISTEN;
+			}
+			break;
+		case NRF905_SLEEP_STATE_LISTEN:
+			// Beacon should start one guard time after listening starts, wait for another guard time after it should have finished
+			if(elapsed < (beaconTime + (guard * 2UL) + (listenWiden * 2)) || radio->receiveBusy())
+				break;
+
+			if(sleeper.missed())
+			{
+				// Clock estimate must be too far out, stay listening until a beacon turns up and measure the drift again
+				isSynced = false;
+				driftValid = false;
+				state = NRF905_SLEEP_STATE_SEARCH;
+			}
+			else
+				sleep();
+			break;
+		case STATE_SENDING:
+			// Give up waiting if DR never goes high
+			if((!radio->service() || radio->transmitting()) && elapsed < (unsigned long)slotLen + NRF905_POWERUP_TIME)
+				break;
+
+			txPending = false;
+			sleep();
+			break;
+		default:
+			break;
+	}
+}
+
+uint32_t nRF905Tdma::sleepTime()
+{
+	if(radio == NULL)
+		return 0;
+
+	if(isBase)
+	{
+		long remaining = (long)(frameStart + frameTime() - micros());
+		return (remaining > 0) ? remaining : 0;
+	}
+	if(state == NRF905_SLEEP_STATE_SLEEP && !beaconReady)
+		return sleeper.remaining(actionTime);
+	return 0;
+}
+
+void nRF905Tdma::receive()
+{
+	if(radio == NULL || isBase || beaconReady)
+		return;
+
+	// Anything past the end of the payload must not look like an assignment
+	memset(beacon, 0xFF, sizeof(beacon));
+	radio->read(beacon, radio->getPayloadSizeRX());
+	beaconTimestamp = radio->rxTimestamp();
+
+	// Make sure the beacon is in the buffer before service() can see it
+	NRF905_MEMORY_BARRIER();
+	beaconReady = true;
+}
+
+bool nRF905Tdma::synced()
+{
+	return isSynced;
+}
+
+uint16_t nRF905Tdma::slot()
+{
+	if(!slotCount)
+		return 0;
+	if(slotAssigned && assignedSlot < slotCount)
+		return assignedSlot;
+	return id % slotCount;
+}
+
+uint16_t nRF905Tdma::slotTime()
+{
+	return slotLen;
+}
+
+float nRF905Tdma::drift()
+{
+	return driftPPM;
+}
+
+uint32_t nRF905Tdma::onTime()
+{
+	return sleeper.onTime();
+}
@@ -0,0 +1,249 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_TDMA_H_
+#define NRF905_TDMA_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_sleep.h"
+#include "nRF905_config.h"
+
+#define NRF905_TDMA_BEACON_HEADER	13 ///< Beacon size without any slot assignments, the beacon payload size must be at least this big
+
+/**
+* @brief Time slots for a fleet of sensor nodes sending to one base station
+*
+* The base station sends a beacon at the start of every frame, the rest of the frame is split into one slot per node.
+* Each slot is long enough for a node to send one payload plus a guard time either side to allow for clock errors.
+* Nodes sleep between slots, waking up to send in their own slot and to listen for a beacon every now and then to stay in sync.
+* A node works out how fast or slow its clock runs compared to the base station from the beacons and corrects for it.
+*
+* A node uses slot `id % slots` unless the base station has given it a different slot with .assign().
+*
+* Beacons are sent to the beacon address, nodes send their payloads to the base station's listen address.
+* The base station's transmit payload size (beacon) must match the nodes' receive payload size and be at least ::NRF905_TDMA_BEACON_HEADER bytes,
+* each extra 4 bytes carries one slot assignment. The nodes' transmit payload size must match the base station's receive payload size.
+*
+* Nodes: In interrupt mode call .receive() from the \p onRxComplete event, in polled mode call it after .poll() has run the event.
+* If \p NRF905_RX_BUFFER_SLOTS is enabled then .service() does this automatically instead using the timestamp saved with the payload.
+* .service() must be called often on both the base station and the nodes, ideally at least once every guard time.
+*/
+class nRF905Tdma
+{
+private:
+	typedef struct
+	{
+		uint16_t id;
+		uint16_t slot;
+	} assignment_t;
+
+	nRF905* radio;
+	uint32_t beaconAddr;
+	bool isBase;
+
+	// Frame layout, sent in each beacon
+	uint16_t frameNumber;
+	uint16_t slotCount;
+	uint16_t slotLen;
+	uint16_t guard;
+	uint16_t beaconTime; // TX settle time + beacon airtime
+	unsigned long frameStart;
+
+	// Base station
+	assignment_t assignments[NRF905_TDMA_ASSIGNMENTS];
+	uint8_t assignmentCount;
+	uint8_t assignmentNext;
+
+	// Node
+	uint16_t id;
+	uint8_t resync;
+	bool isSynced;
+	bool driftValid;
+	float driftPPM;
+	bool slotAssigned;
+	uint16_t assignedSlot;
+
+	uint8_t state;
+	uint8_t action;
+	unsigned long actionTime;
+	unsigned long listenWiden;
+	unsigned long stateStart;
+	nRF905Sleep sleeper;
+
+	uint32_t sendTo;
+	uint8_t txBuffer[NRF905_MAX_PAYLOAD];
+	uint8_t txLen;
+	bool txPending;
+
+	uint8_t beacon[NRF905_MAX_PAYLOAD];
+	volatile bool beaconReady;
+	unsigned long beaconTimestamp;
+
+	uint32_t frameTime();
+	unsigned long frameOffset(uint32_t frames, uint32_t offset);
+	void sendBeacon();
+	void processBeacon();
+	void plan();
+	void sleep();
+
+public:
+	nRF905Tdma();
+
+/**
+* @brief Start sending beacons as the base station
+*
+* The radio should have already been set up with .begin() and its payload sizes set. The slot length is worked out from the receive payload size.
+*
+* Example: `tdma.beginBase(transceiver, 0x7A5C1E90, 200, 250);`
+*
+* @param [radio] The radio
+* @param [beaconAddr] Address to send beacons to
+* @param [slots] Number of node slots in each frame
+* @param [guard] Guard time at each end of a slot (us), must be bigger than the clock error nodes can build up between beacons plus how late .service() might be called
+* @return (none)
+*/
+	void beginBase(nRF905& radio, uint32_t beaconAddr, uint16_t slots, uint16_t guard);
+
+/**
+* @brief Start as a node and listen for the first beacon
+*
+* The radio should have already been set up with .begin() and its payload sizes set. The listen address is changed to the beacon address.
+*
+* Example: `tdma.beginNode(transceiver, 0x7A5C1E90, 78, true, 8);`
+*
+* @param [radio] The radio
+* @param [beaconAddr] Address the base station sends beacons to
+* @param [id] Node ID (0 - 65534)
+* @param [powerDown] \p true to sleep in power-down mode (2.5uA, but takes 3ms to wake up), \p false to sleep in standby mode (32uA)
+* @param [resync] Listen for a beacon once every this many frames (1 - 255)
+* @return (none)
+*/
+	void beginNode(nRF905& radio, uint32_t beaconAddr, uint16_t id, bool powerDown, uint8_t resync);
+
+/**
+* @brief Give a node a slot
+*
+* Base station only. Assignments are sent a few at a time in the beacons.
+*
+* Example: `tdma.assign(78, 3);`
+*
+* @param [id] Node ID (0 - 65534)
+* @param [slot] Slot number (0 - slots-1)
+* @return \p false if there's no room for another assignment (see \p NRF905_TDMA_ASSIGNMENTS in nRF905_config.h), otherwise \p true
+*/
+	bool assign(uint16_t id, uint16_t slot);
+
+/**
+* @brief Send a payload in the node's next slot
+*
+* Node only. The payload is sent once the node is in sync and has heard enough beacons to know its clock drift, and its slot comes around.
+*
+* Example: `tdma.send(0xE7E7E7E7, buffer, sizeof(buffer));`
+*
+* @param [sendTo] Address to send the payload to
+* @param [data] The data
+* @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
+* @return \p false if the previous payload hasn't been sent yet, otherwise \p true
+*/
+	bool send(uint32_t sendTo, void* data, uint8_t len);
+
+/**
+* @brief See if a payload is waiting for its slot
+*
+* Example: `if(!tdma.pending())`
+*
+* @return \p true if waiting, otherwise \p false
+*/
+	bool pending();
+
+/**
+* @brief Send beacons, or wake up, send, listen and go back to sleep when needed
+*
+* Call this as often as possible.
+*
+* Example: `tdma.service();`
+*
+* @return (none)
+*/
+	void service();
+
+/**
+* @brief How long until .service() next has something to do
+*
+* A node can put the MCU to sleep for this long (as long as the radio's interrupts can still wake it up).
+*
+* Example: `uint32_t time = tdma.sleepTime();`
+*
+* @return Time (us), \p 0 if .service() needs calling straight away
+*/
+	uint32_t sleepTime();
+
+/**
+* @brief Read a beacon from the radio
+*
+* Node only. Call this from the \p onRxComplete event, the time the beacon arrived (see .rxTimestamp()) is used to work out when the frame started.
+*
+* Example: `tdma.receive();`
+*
+* @return (none)
+*/
+	void receive();
+
+/**
+* @brief See if the node has heard a beacon recently enough to know when its slot is
+*
+* Example: `if(tdma.synced())`
+*
+* @return \p true if in sync, otherwise \p false
+*/
+	bool synced();
+
+/**
+* @brief The node's slot number
+*
+* Example: `Serial.println(tdma.slot());`
+*
+* @return Slot number
+*/
+	uint16_t slot();
+
+/**
+* @brief Length of each node slot
+*
+* Guard time, TX settle time, payload airtime and another guard time.
+*
+* Example: `Serial.println(tdma.slotTime());`
+*
+* @return Slot length (us)
+*/
+	uint16_t slotTime();
+
+/**
+* @brief How fast the node's clock runs compared to the base station's clock
+*
+* Example: `Serial.println(tdma.drift());`
+*
+* @return Parts per million, positive means the node's clock is fast
+*/
+	float drift();
+
+/**
+* @brief Total time the radio has been awake (powering up, listening or sending) since .beginNode()
+*
+* Wraps around after about 71 minutes of on-time.
+*
+* Example: `Serial.println(tdma.onTime());`
+*
+* @return On-time (us)
+*/
+	uint32_t onTime();
+};
+
+#endif /* NRF905_TDMA_H_ */
@@ -0,0 +1,259 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_wor.h"
+#include "nRF905_config.h"
+#include "nRF905_defs.h"
+
+// States
+#define STATE_SLEEP		0
+#define STATE_WAKING	1 // Powering up from power-down before listening
+#define STATE_LISTEN	2 // Listening for the window
+#define STATE_AWAKE		3 // Something was heard, waiting for the packet
+#define STATE_SENDING	4
+
+// Power states
+#define POWER_DOWN		0
+#define POWER_STANDBY	1
+#define POWER_RX		2
+#define POWER_TX		3
+
+// Largest time count for each power state (us), 4 of them still add up to less than 32 bits
+#define POWER_TIME_MAX	0x3FFFFFFF
+
+nRF905Wor::nRF905Wor()
+{
+	radio = NULL;
+	period = 0;
+	window = 0;
+	sleepPowerDown = false;
+	state = STATE_SLEEP;
+	stateStart = 0;
+	stateTime = 0;
+	wakeStart = 0;
+	addrMatched = false;
+	autoRetransmit = false;
+	powerState = POWER_STANDBY;
+	powerStateStart = 0;
+	memset(powerTime, 0, sizeof(powerTime));
+}
+
+void nRF905Wor::begin(nRF905& radio, uint16_t period, uint16_t window, bool powerDown)
+{
+	this->radio = &radio;
+	this->period = period * 1000UL;
+	this->window = window;
+	sleepPowerDown = powerDown;
+
+	powerStateStart = micros();
+	resetCurrent();
+	sleep(this->period);
+}
+
+// Long enough to cover a whole period of the receiver including its listen window and a complete packet
+unsigned long nRF905Wor::burstTime()
+{
+	return period + NRF905_RX_SETTLE_TIME + window + (radio->airtime() * 2);
+}
+
+// Time left until the next listen window is due
+unsigned long nRF905Wor::nextWake()
+{
+	unsigned long awake = micros() - wakeStart;
+	return (awake < period) ? (period - awake) : 0;
+}
+
+void nRF905Wor::sleep(unsigned long time)
+{
+	if(sleepPowerDown)
+	{
+		radio->powerDown();
+		setPowerState(POWER_DOWN);
+	}
+	else
+	{
+		radio->standby();
+		setPowerState(POWER_STANDBY);
+	}
+
+	state = STATE_SLEEP;
+	stateStart = micros();
+	stateTime = time;
+}
+
+void nRF905Wor::setPowerState(uint8_t state)
+{
+	unsigned long now = micros();
+	uint32_t elapsed = now - powerStateStart;
+	powerStateStart = now;
+
+	// Halve everything (including the new time) until no count goes over POWER_TIME_MAX, the ratios stay the same
+	// Checked on each count since adding them all up first could overflow before the check
+	while(elapsed > POWER_TIME_MAX - powerTime[powerState])
+	{
+		for(uint8_t i=0;i<4;i++)
+			powerTime[i] /= 2;
+		elapsed /= 2;
+	}
+
+	powerTime[powerState] += elapsed;
+	powerState = state;
+}
+
+bool nRF905Wor::service()
+{
+	if(radio == NULL)
+		return false;
+
+	if(radio->polled())
+		radio->poll();
+
+	unsigned long elapsed = micros() - stateStart;
+
+	switch(state)
+	{
+		case STATE_SLEEP:
+			if(sleepPowerDown && elapsed + NRF905_POWERUP_TIME >= stateTime)
+			{
+				// Power up early so the radio is ready to listen on time
+				radio->prepareWake();
+				setPowerState(POWER_STANDBY);
+				state = STATE_WAKING;
+				return false;
+			}
+			else if(elapsed < stateTime)
+				return false;
+			// Fall through
+		case STATE_WAKING:
+			if(radio->wakeRemaining())
+				return false;
+			radio->RX();
+			setPowerState(POWER_RX);
+			state = STATE_LISTEN;
+			stateStart = micros();
+			wakeStart = stateStart;
+			addrMatched = false;
+			break;
+		case STATE_LISTEN:
+			if(elapsed < NRF905_RX_SETTLE_TIME)
+				break;
+
+			if(radio->airwayBusy() || radio->receiveBusy())
+			{
+				state = STATE_AWAKE;
+				stateStart = micros();
+			}
+			else if(elapsed >= window + (unsigned long)NRF905_RX_SETTLE_TIME)
+				sleep(nextWake());
+			break;
+		case STATE_AWAKE:
+			if(radio->receiveBusy())
+				addrMatched = true;
+			else if(addrMatched)
+			{
+				// Packet has been received (or was bad), sleep through the rest of the burst
+				sleep(burstTime());
+				break;
+			}
+
+			// Carrier was for someone else or the packet never came
+			if(elapsed >= radio->airtime() * 2UL)
+				sleep(nextWake());
+			break;
+		case STATE_SENDING:
+			if(elapsed < stateTime)
+				break;
+
+			radio->standby();
+			radio->setAutoRetransmit(autoRetransmit);
+			sleep(period);
+			break;
+		default:
+			break;
+	}
+
+	return (state != STATE_SLEEP && state != STATE_WAKING);
+}
+
+bool nRF905Wor::send(uint32_t sendTo, void* data, uint8_t len)
+{
+	if(radio == NULL || state == STATE_SENDING)
+		return false;
+
+	if(state == STATE_AWAKE)
+		return false;
+
+	autoRetransmit = radio->getAutoRetransmit();
+	radio->setAutoRetransmit(true);
+	radio->write(sendTo, data, len);
+
+	// Keep sending the payload until service() ends the burst
+	if(!radio->TX(NRF905_NEXTMODE_TX, true))
+	{
+		radio->setAutoRetransmit(autoRetransmit);
+		return false;
+	}
+
+	setPowerState(POWER_TX);
+	state = STATE_SENDING;
+	stateStart = micros();
+
+	// The burst doesn't actually start until the radio has powered up and settled
+	stateTime = burstTime() + radio->wakeRemaining() + NRF905_TX_SETTLE_TIME;
+
+	return true;
+}
+
+bool nRF905Wor::sending()
+{
+	return (state == STATE_SENDING);
+}
+
+float nRF905Wor::averageCurrent()
+{
+	// Count the time spent in the current state so far
+	setPowerState(powerState);
+
+	float txCurrent;
+	switch(radio != NULL ? radio->getTransmitPower() : NRF905_PWR_10)
+	{
+		case NRF905_PWR_n10:
+			txCurrent = NRF905_CURRENT_TX_n10;
+			break;
+		case NRF905_PWR_n2:
+			txCurrent = NRF905_CURRENT_TX_n2;
+			break;
+		case NRF905_PWR_6:
+			txCurrent = NRF905_CURRENT_TX_6;
+			break;
+		default:
+			txCurrent = NRF905_CURRENT_TX_10;
+			break;
+	}
+
+	// Can't overflow, each count is no more than POWER_TIME_MAX
+	uint32_t total = powerTime[POWER_DOWN] + powerTime[POWER_STANDBY] + powerTime[POWER_RX] + powerTime[POWER_TX];
+	if(!total)
+		return 0;
+
+	return (
+		(powerTime[POWER_DOWN] * (float)NRF905_CURRENT_POWERDOWN) +
+		(powerTime[POWER_STANDBY] * (float)NRF905_CURRENT_STANDBY) +
+		(powerTime[POWER_RX] * (float)NRF905_CURRENT_RX) +
+		(powerTime[POWER_TX] * txCurrent)
+	) / total;
+}
+
+void nRF905Wor::resetCurrent()
+{
+	setPowerState(powerState);
+	memset(powerTime, 0, sizeof(powerTime));
+}
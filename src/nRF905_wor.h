@@ -0,0 +1,127 @@
+/*
+ * Project: nRF905 Radio Library for Arduino
+ * Author: Zak Kemble, contact@zakkemble.net
+ * Copyright: (C) 2020 by Zak Kemble
+ * License: GNU GPL v3 (see License.txt)
+ * Web: https://blog.zakkemble.net/nrf905-avrarduino-librarydriver/
+ */
+
+#ifndef NRF905_WOR_H_
+#define NRF905_WOR_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "nRF905.h"
+#include "nRF905_config.h"
+
+/**
+* @brief Wake-on-radio, low power listening
+*
+* Instead of staying in receive mode all the time the radio sleeps (standby or power-down) and only listens for a short window once every period.
+* If carrier detect or address match goes high during the window then it stays in receive mode until the packet has arrived, otherwise it goes straight back to sleep.
+*
+* To make sure the receiver is listening at some point while a packet is being sent, .send() turns on auto-retransmit and sends the payload over and over for a whole period plus the window.
+* The receiver sleeps for the same amount of time after getting a packet so it doesn't pick up the same burst again.
+* Both ends must use the same period and window.
+*
+* Received payloads are handled as normal with the \p onRxComplete event (or .readPacket() if \p NRF905_RX_BUFFER_SLOTS is enabled), the payload must be read for the radio to go back to sleep straight away.
+* .service() must be called often, at least a few times during each window.
+*/
+class nRF905Wor
+{
+private:
+	nRF905* radio;
+	unsigned long period;
+	uint16_t window;
+	bool sleepPowerDown;
+
+	uint8_t state;
+	unsigned long stateStart;
+	unsigned long stateTime;
+	unsigned long wakeStart;
+	bool addrMatched;
+	bool autoRetransmit;
+
+	// Time spent in each power state for working out the average current
+	uint8_t powerState;
+	unsigned long powerStateStart;
+	uint32_t powerTime[4];
+
+	unsigned long burstTime();
+	unsigned long nextWake();
+	void sleep(unsigned long time);
+	void setPowerState(uint8_t state);
+
+public:
+	nRF905Wor();
+
+/**
+* @brief Attach to a radio and start sleeping
+*
+* Example: `wor.begin(transceiver, 500, 500, true);`
+*
+* @param [radio] The radio
+* @param [period] Time from the start of one listen window to the next (ms)
+* @param [window] How long to listen for (us), this is on top of the 650us it takes receive mode to settle
+* @param [powerDown] \p true to sleep in power-down mode (2.5uA, but takes 3ms to wake up), \p false to sleep in standby mode (32uA)
+* @return (none)
+*/
+	void begin(nRF905& radio, uint16_t period, uint16_t window, bool powerDown);
+
+/**
+* @brief Wake up, listen and go back to sleep when needed
+*
+* Call this as often as possible.
+*
+* Example: `wor.service();`
+*
+* @return \p true if the radio is awake (listening or sending), \p false if it's asleep
+*/
+	bool service();
+
+/**
+* @brief Send a payload as a burst long enough for a sleeping receiver to wake up and catch it
+*
+* The burst lasts for the period plus the window, .service() ends it and puts the radio back to sleep.
+*
+* Example: `wor.send(0xB54CAB34, buffer, sizeof(buffer));`
+*
+* @param [sendTo] Address to send the payload to
+* @param [data] The data
+* @param [len] Data length (max ::NRF905_MAX_PAYLOAD)
+* @return \p false if a burst is already being sent or other transmissions are going on, otherwise \p true
+*/
+	bool send(uint32_t sendTo, void* data, uint8_t len);
+
+/**
+* @brief See if a burst is still being sent
+*
+* Example: `while(wor.sending()) wor.service();`
+*
+* @return \p true if sending, otherwise \p false
+*/
+	bool sending();
+
+/**
+* @brief Average current used by the radio
+*
+* Worked out from the time spent in each mode since .begin() or .resetCurrent() and the typical currents from the datasheet (see nRF905_defs.h).
+* Older time counts for less once the time spent in any one mode passes about 17 minutes.
+*
+* Example: `Serial.println(wor.averageCurrent());`
+*
+* @return Average current (uA)
+*/
+	float averageCurrent();
+
+/**
+* @brief Start working out the average current again
+*
+* Example: `wor.resetCurrent();`
+*
+* @return (none)
+*/
+	void resetCurrent();
+};
+
+#endif /* NRF905_WOR_H_ */